@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureBotCharacter.h"
+
+#include "Components/SkeletalMeshComponent.h"
+
+AAdventureBotCharacter::AAdventureBotCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.DoNotCreateDefaultSubobject(CameraBoomName).DoNotCreateDefaultSubobject(FollowCameraName))
+{
+	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
+
+	// Climbing montages drive root motion and motion warping, so they keep ticking when nobody sees the bot
+	GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+	GetMesh()->bComponentUseFixedSkelBounds = true;
+	GetMesh()->SetGenerateOverlapEvents(false);
+}
+
+void AAdventureBotCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+{
+	// Bots are driven by their controller only, nothing to bind
+}
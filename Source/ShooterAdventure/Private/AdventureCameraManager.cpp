@@ -4,26 +4,35 @@
 #include "AdventureCameraManager.h"
 
 #include "Components/CapsuleComponent.h"
+#include "GameFramework/SpringArmComponent.h"
 #include "ShooterAdventure/ShooterAdventureCharacter.h"
 #include "ShooterAdventure/Public/AdventureMovementComponent.h"
 
+DECLARE_STATS_GROUP(TEXT("AdventureCamera"), STATGROUP_AdventureCamera, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Update View Target"), STAT_AdventureCameraUpdate, STATGROUP_AdventureCamera);
+DECLARE_CYCLE_STAT(TEXT("Occlusion"), STAT_AdventureCameraOcclusion, STATGROUP_AdventureCamera);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Occlusion Sweeps"), STAT_AdventureCameraOcclusionSweeps, STATGROUP_AdventureCamera);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Late Occlusion Results"), STAT_AdventureCameraLateResults, STATGROUP_AdventureCamera);
+
 AAdventureCameraManager::AAdventureCameraManager()
 {
 }
 
 void AAdventureCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AdventureCameraUpdate);
+
 	Super::UpdateViewTarget(OutVT, DeltaTime);
 
-	if (AShooterAdventureCharacter* Character = Cast<AShooterAdventureCharacter>(GetOwningPlayerController()->GetPawn()))
+	if (AShooterAdventureCharacter* Character = GetViewCharacter())
 	{
+		if(bAsyncOcclusion)
+		{
+			UpdateOcclusion(Character, OutVT, DeltaTime);
+		}
+
 		UAdventureMovementComponent* MovementComponent = Character->GetAdventureMovementComponent();
-		ACharacter* DefaultCharacterObj = Character->GetClass()->GetDefaultObject<ACharacter>();
-		FVector TargetCrouchOffset = FVector(
-			0,
-			0,
-			MovementComponent->GetCrouchedHalfHeight() - DefaultCharacterObj->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()
-			);
+		FVector TargetCrouchOffset = FVector(0, 0, GetCrouchOffsetZ(Character));
 
 		FVector Offset = FMath::Lerp(FVector::ZeroVector, TargetCrouchOffset, FMath::Clamp(CrouchBlendTime/ CrouchBlendDuration, 0.f,1.f));
 		
@@ -49,3 +58,83 @@ void AAdventureCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float DeltaT
 		}
 	}
 }
+
+AShooterAdventureCharacter* AAdventureCameraManager::GetViewCharacter()
+{
+	APawn* Pawn = GetOwningPlayerController()->GetPawn();
+	if(Pawn != CachedPawn.Get())
+	{
+		// The previous pawn gets its own collision test back
+		SetBoomCollision(CachedCharacter.Get(), true);
+
+		CachedPawn = Pawn;
+		CachedCharacter = Cast<AShooterAdventureCharacter>(Pawn);
+		OcclusionTraceHandle = FTraceHandle();
+		OcclusionFraction = 1.f;
+		TargetOcclusionFraction = 1.f;
+
+		SetBoomCollision(CachedCharacter.Get(), !bAsyncOcclusion);
+	}
+
+	return CachedCharacter.Get();
+}
+
+float AAdventureCameraManager::GetCrouchOffsetZ(const AShooterAdventureCharacter* Character)
+{
+	UClass* Class = Character->GetClass();
+	if(Class != CachedCrouchClass.Get())
+	{
+		const ACharacter* DefaultCharacterObj = Class->GetDefaultObject<ACharacter>();
+		CachedCrouchClass = Class;
+		CachedCrouchOffsetZ = DefaultCharacterObj->GetCharacterMovement()->GetCrouchedHalfHeight() - DefaultCharacterObj->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	}
+
+	return CachedCrouchOffsetZ;
+}
+
+void AAdventureCameraManager::SetBoomCollision(AShooterAdventureCharacter* Character, bool bEnabled) const
+{
+	if(USpringArmComponent* CameraBoom = Character ? Character->GetCameraBoom() : nullptr)
+	{
+		CameraBoom->bDoCollisionTest = bEnabled;
+	}
+}
+
+void AAdventureCameraManager::UpdateOcclusion(const AShooterAdventureCharacter* Character, FTViewTarget& OutVT, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AdventureCameraOcclusion);
+
+	const USpringArmComponent* CameraBoom = Character->GetCameraBoom();
+	if(CameraBoom == nullptr)
+	{
+		return;
+	}
+
+	// Last frame's sweep, if it isn't done yet keep the previous target
+	UWorld* World = GetWorld();
+	FTraceDatum Datum;
+	if(World->QueryTraceData(OcclusionTraceHandle, Datum))
+	{
+		TargetOcclusionFraction = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit ? Datum.OutHits[0].Time : 1.f;
+	}
+	else if(OcclusionTraceHandle.IsValid())
+	{
+		INC_DWORD_STAT(STAT_AdventureCameraLateResults);
+	}
+
+	// Pull in at once so the camera never sits inside the occluder, ease back out to hide the one frame of latency
+	OcclusionFraction = TargetOcclusionFraction < OcclusionFraction
+		? TargetOcclusionFraction
+		: FMath::FInterpTo(OcclusionFraction, TargetOcclusionFraction, DeltaTime, OcclusionRecoverSpeed);
+
+	const FVector Pivot = CameraBoom->GetComponentLocation() + CameraBoom->TargetOffset;
+	const FVector Desired = OutVT.POV.Location;
+	OutVT.POV.Location = Pivot + (Desired - Pivot) * OcclusionFraction;
+
+	// Sweep where the arm will be next frame, the result is read back then
+	const FVector Ahead = Character->GetVelocity() * DeltaTime;
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(AdventureCameraOcclusion), false, Character);
+	OcclusionTraceHandle = World->AsyncSweepByChannel(EAsyncTraceType::Single, Pivot + Ahead, Desired + Ahead, FQuat::Identity,
+		CameraBoom->ProbeChannel, FCollisionShape::MakeSphere(CameraBoom->ProbeSize), Params);
+	INC_DWORD_STAT(STAT_AdventureCameraOcclusionSweeps);
+}
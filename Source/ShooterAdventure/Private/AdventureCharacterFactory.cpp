@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureCharacterFactory.h"
+
+#include "ShooterAdventureGameMode.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "Engine/Engine.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+
+namespace AdventureCharacterFactory
+{
+	constexpr float BotSpacing = 150.f;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnBotsCommand(
+	TEXT("Adventure.Bots.Spawn"),
+	TEXT("Spawns Count bots (default 100) in a grid in front of the first player and logs how long spawning took"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if(World == nullptr || World->GetNetMode() == NM_Client)
+		{
+			UE_LOG(LogAdventureMovement, Warning, TEXT("Adventure.Bots.Spawn only runs with authority"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		const int32 Columns = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt((float)Count)));
+
+		FVector Origin = FVector::ZeroVector;
+		if(const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0))
+		{
+			Origin = Player->GetActorLocation() + Player->GetActorForwardVector() * AdventureCharacterFactory::BotSpacing * 2;
+		}
+
+		int32 NumSpawned = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			const FVector Offset((Index / Columns) * AdventureCharacterFactory::BotSpacing, (Index % Columns - Columns / 2) * AdventureCharacterFactory::BotSpacing, 0);
+			if(UAdventureCharacterFactory::SpawnCharacter(World, EAdventureCharacterArchetype::Bot, FTransform(Origin + Offset)))
+			{
+				NumSpawned++;
+			}
+		}
+		const double SpawnMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOG(LogAdventureMovement, Log, TEXT("Spawned %d/%d bots in %.2f ms (%.3f ms each). Adventure.Characters.ReportSizes and stat game report memory and frame cost"),
+			NumSpawned, Count, SpawnMs, NumSpawned > 0 ? SpawnMs / NumSpawned : 0.0);
+	}));
+
+EAdventureCharacterArchetype UAdventureCharacterFactory::GetArchetypeFor(const AController* Controller)
+{
+	return Cast<APlayerController>(Controller) ? EAdventureCharacterArchetype::Player : EAdventureCharacterArchetype::Bot;
+}
+
+TSubclassOf<APawn> UAdventureCharacterFactory::GetCharacterClass(const UObject* WorldContextObject, EAdventureCharacterArchetype Archetype)
+{
+	const UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	const AShooterAdventureGameMode* GameMode = World ? World->GetAuthGameMode<AShooterAdventureGameMode>() : nullptr;
+	if(GameMode == nullptr)
+	{
+		// Other game modes still get the classes configured for ours
+		GameMode = GetDefault<AShooterAdventureGameMode>();
+	}
+
+	if(Archetype == EAdventureCharacterArchetype::Bot)
+	{
+		return GameMode->GetBotPawnClass();
+	}
+
+	return GameMode->DefaultPawnClass;
+}
+
+APawn* UAdventureCharacterFactory::SpawnCharacter(const UObject* WorldContextObject, EAdventureCharacterArchetype Archetype, const FTransform& Transform)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if(World == nullptr)
+	{
+		return nullptr;
+	}
+
+	UClass* Class = GetCharacterClass(WorldContextObject, Archetype);
+	if(Class == nullptr)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	APawn* Pawn = World->SpawnActor<APawn>(Class, Transform, SpawnParams);
+	if(Pawn && Archetype == EAdventureCharacterArchetype::Bot && Pawn->Controller == nullptr)
+	{
+		Pawn->SpawnDefaultController();
+	}
+
+	return Pawn;
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureLaunchRootMotion.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+FRootMotionSource_AdventureLaunch::FRootMotionSource_AdventureLaunch()
+{
+	// The arc replaces velocity completely, gravity included
+	AccumulateMode = ERootMotionAccumulateMode::Override;
+}
+
+void FRootMotionSource_AdventureLaunch::SetArc(const FVector& Start, const FVector& LaunchVelocity, float InGravityZ, float InDuration)
+{
+	StartLocation = Start;
+	GravityZ = InGravityZ;
+	Duration = InDuration;
+	TargetLocation = Start + LaunchVelocity * InDuration + FVector(0.f, 0.f, 0.5f * InGravityZ * FMath::Square(InDuration));
+}
+
+FVector FRootMotionSource_AdventureLaunch::GetVelocityAtTime(float Time) const
+{
+	if(Duration <= UE_SMALL_NUMBER)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FVector StartVelocity = (TargetLocation - StartLocation) / Duration - FVector(0.f, 0.f, 0.5f * GravityZ * Duration);
+	return StartVelocity + FVector(0.f, 0.f, GravityZ * Time);
+}
+
+FRootMotionSource* FRootMotionSource_AdventureLaunch::Clone() const
+{
+	return new FRootMotionSource_AdventureLaunch(*this);
+}
+
+bool FRootMotionSource_AdventureLaunch::Matches(const FRootMotionSource* Other) const
+{
+	if(!FRootMotionSource::Matches(Other))
+	{
+		return false;
+	}
+
+	// Matches already checked the script struct. Only the shape of the arc is compared, client and server start it
+	// wherever they each had the character, which differs by the error a correction is about to fix
+	const FRootMotionSource_AdventureLaunch* OtherLaunch = static_cast<const FRootMotionSource_AdventureLaunch*>(Other);
+	return (TargetLocation - StartLocation).Equals(OtherLaunch->TargetLocation - OtherLaunch->StartLocation, 1.f)
+		&& FMath::IsNearlyEqual(GravityZ, OtherLaunch->GravityZ);
+}
+
+void FRootMotionSource_AdventureLaunch::PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent)
+{
+	RootMotionParams.Clear();
+
+	if(Duration > UE_SMALL_NUMBER && MovementTickTime > UE_SMALL_NUMBER)
+	{
+		// The velocity halfway through the step is the average over it, gravity changes velocity linearly
+		const float StartTime = FMath::Clamp(GetTime(), 0.f, Duration);
+		const float EndTime = FMath::Clamp(GetTime() + SimulationTime, 0.f, Duration);
+		const FVector Force = GetVelocityAtTime(0.5f * (StartTime + EndTime)) * (EndTime - StartTime) / MovementTickTime;
+		RootMotionParams.Set(FTransform(Force));
+	}
+
+	SetTime(GetTime() + SimulationTime);
+}
+
+bool FRootMotionSource_AdventureLaunch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	if(!FRootMotionSource::NetSerialize(Ar, Map, bOutSuccess))
+	{
+		return false;
+	}
+
+	Ar << StartLocation;
+	Ar << TargetLocation;
+	Ar << GravityZ;
+
+	bOutSuccess = true;
+	return true;
+}
+
+UScriptStruct* FRootMotionSource_AdventureLaunch::GetScriptStruct() const
+{
+	return FRootMotionSource_AdventureLaunch::StaticStruct();
+}
+
+FString FRootMotionSource_AdventureLaunch::ToSimpleString() const
+{
+	return FString::Printf(TEXT("[ID:%u]FRootMotionSource_AdventureLaunch %s %s -> %s over %.2fs"),
+		LocalID, *InstanceName.GetPlainNameString(), *StartLocation.ToCompactString(), *TargetLocation.ToCompactString(), Duration);
+}
@@ -3,10 +3,90 @@
 
 #include "AdventureMovementComponent.h"
 
+#include "AdventureMovementTelemetry.h"
+#include "AdventureConfigMigration.h"
+#include "AdventureLaunchRootMotion.h"
+#include "ClimbingComponent.h"
+#include "Ledge.h"
+#include "LedgeRegistry.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/Character.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "ShooterAdventure/ShooterAdventure.h"
 #include "ShooterAdventure/ShooterAdventureCharacter.h"
 
+DECLARE_STATS_GROUP(TEXT("AdventureMovement"), STATGROUP_AdventureMovement, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Custom Mode Physics"), STAT_AdventureCustomPhysics, STATGROUP_AdventureMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Steps"), STAT_AdventureFixedSteps, STATGROUP_AdventureMovement);
+
+static FAutoConsoleCommandWithWorldAndArgs SimulationClockCommand(
+	TEXT("Adventure.Movement.Clock"),
+	TEXT("Adventure.Movement.Clock Variable|Fixed|Async. Switches the custom mode clock of every adventure character, compare with stat AdventureMovement. Async only takes the step count from the physics tick, the modes still run on the game thread"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const FString Mode = Args.Num() > 0 ? Args[0] : TEXT("Fixed");
+		const bool bFixed = Mode != TEXT("Variable");
+		const bool bAsync = Mode == TEXT("Async");
+		int32 NumComponents = 0;
+		for (TObjectIterator<UAdventureMovementComponent> It; It; ++It)
+		{
+			if(It->GetWorld() == World)
+			{
+				It->SetSimulationClock(bFixed, bAsync);
+				NumComponents++;
+			}
+		}
+		UE_LOG(LogAdventureMovement, Log, TEXT("Custom mode clock set to %s on %d characters"), bAsync ? TEXT("Async") : bFixed ? TEXT("Fixed") : TEXT("Variable"), NumComponents);
+	}));
+
+static FAutoConsoleCommandWithWorld ReportMovementHistoryCommand(
+	TEXT("Adventure.MovementHistory.Report"),
+	TEXT("Logs the movement history memory used by every adventure character in the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		SIZE_T TotalBytes = 0;
+		int32 NumCharacters = 0;
+		for (TObjectIterator<UAdventureMovementComponent> It; It; ++It)
+		{
+			if(It->GetWorld() != World)
+			{
+				continue;
+			}
+
+			const FAdventureMovementHistory& History = It->GetMovementHistory();
+			UE_LOG(LogAdventureMovement, Log, TEXT("%s: %d/%d samples, %llu bytes"), *GetNameSafe(It->GetOwner()), History.Num(), History.GetCapacity(), (uint64)History.GetAllocatedSize());
+			TotalBytes += History.GetAllocatedSize();
+			NumCharacters++;
+		}
+		UE_LOG(LogAdventureMovement, Log, TEXT("Movement history: %d characters, %llu bytes total"), NumCharacters, (uint64)TotalBytes);
+	}));
+
+
+static FAutoConsoleCommandWithWorld SavedMovePoolStatsCommand(
+	TEXT("Adventure.SavedMovePool.Stats"),
+	TEXT("Logs saved move pool usage for every adventure character in the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TObjectIterator<UAdventureMovementComponent> It; It; ++It)
+		{
+			UAdventureMovementComponent::FSavedMovePoolStats Stats;
+			if(It->GetWorld() == World && It->GetSavedMovePoolStats(Stats))
+			{
+				UE_LOG(LogAdventureMovement, Log, TEXT("%s: capacity %d, in use %d, high water %d, fallbacks %d"), *GetNameSafe(It->GetOwner()),
+					Stats.Capacity, Stats.InUse, Stats.HighWaterMark, Stats.FallbackAllocations);
+			}
+		}
+	}));
+
+static FAutoConsoleCommand SavedMovePoolBenchmarkCommand(
+	TEXT("Adventure.SavedMovePool.Benchmark"),
+	TEXT("Adventure.SavedMovePool.Benchmark [Capacity] [NumMoves]. Defaults to one minute of 240 Hz moves"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Capacity = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		const int32 NumMoves = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 240 * 60;
+		UAdventureMovementComponent::RunSavedMovePoolBenchmark(Capacity, NumMoves);
+	}));
 
 #pragma region Saved Variables - Server-Client
 
@@ -19,15 +99,45 @@ bool UAdventureMovementComponent::FSavedMove_Adventure::CanCombineWith(const FSa
 		return false;
 	}
 
+	if (Saved_LedgeId != NewSaveMove->Saved_LedgeId)
+	{
+		return false;
+	}
+
+	if (Saved_LaunchDuration > 0.f || NewSaveMove->Saved_LaunchDuration > 0.f)
+	{
+		return false;
+	}
+
 	return FSavedMove_Character::CanCombineWith(NewMove, InCharacter, MaxDelta);
 }
 
+bool UAdventureMovementComponent::FSavedMove_Adventure::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
+{
+	// A dropped launch move leaves the server hanging while the client is already in the air
+	if (Saved_LaunchDuration > 0.f)
+	{
+		return true;
+	}
+
+	return FSavedMove_Character::IsImportantMove(LastAckedMove);
+}
+
 void UAdventureMovementComponent::FSavedMove_Adventure::Clear()
 {
 	FSavedMove_Character::Clear();
 	Saved_bWantsToSprint = 0;
 	Saved_bWantstoRoll = 0;
 	Saved_bPreviousWantstoCrouch = 0;
+	Saved_SimTimeAccumulator = 0.f;
+	Saved_StepTimeAccumulator = 0.f;
+	Saved_RollTicksLeft = 0;
+	Saved_RollCooldownTicksLeft = 0;
+	Saved_ClimbingTimerTicksLeft = 0;
+	Saved_ClimbingTimerSerial = 0;
+	Saved_LedgeId = 0;
+	Saved_LaunchVelocity = FVector::ZeroVector;
+	Saved_LaunchDuration = 0.f;
 }
 
 uint8 UAdventureMovementComponent::FSavedMove_Adventure::GetCompressedFlags() const
@@ -47,6 +157,15 @@ void UAdventureMovementComponent::FSavedMove_Adventure::SetMoveFor(ACharacter* C
 	Saved_bWantsToSprint = CharacterMovement->Safe_bWantsToSprint;
 	Saved_bPreviousWantstoCrouch = CharacterMovement->Safe_bPreviousWantsToCrouch;
 	Saved_bWantstoRoll = CharacterMovement->Safe_bWantsToRoll;
+	Saved_SimTimeAccumulator = CharacterMovement->SimTimeAccumulator;
+	Saved_StepTimeAccumulator = CharacterMovement->StepTimeAccumulator;
+	Saved_RollTicksLeft = CharacterMovement->RollTicksLeft;
+	Saved_RollCooldownTicksLeft = CharacterMovement->RollCooldownTicksLeft;
+	Saved_ClimbingTimerTicksLeft = CharacterMovement->ClimbingTimerTicksLeft;
+	Saved_ClimbingTimerSerial = CharacterMovement->ClimbingTimerSerial;
+	Saved_LedgeId = CharacterMovement->AdventureCharacterOwner ? CharacterMovement->AdventureCharacterOwner->GetCurrentLedgeId() : 0;
+	Saved_LaunchVelocity = CharacterMovement->Safe_LaunchVelocity;
+	Saved_LaunchDuration = CharacterMovement->Safe_LaunchDuration;
 }
 
 void UAdventureMovementComponent::FSavedMove_Adventure::PrepMoveFor(ACharacter* C)
@@ -57,17 +176,122 @@ void UAdventureMovementComponent::FSavedMove_Adventure::PrepMoveFor(ACharacter*
 	CharacterMovement->Safe_bWantsToSprint = Saved_bWantsToSprint;
 	CharacterMovement->Safe_bPreviousWantsToCrouch = Saved_bPreviousWantstoCrouch;
 	CharacterMovement->Safe_bWantsToRoll = Saved_bWantstoRoll;
+	CharacterMovement->SimTimeAccumulator = Saved_SimTimeAccumulator;
+	CharacterMovement->StepTimeAccumulator = Saved_StepTimeAccumulator;
+	CharacterMovement->RollTicksLeft = Saved_RollTicksLeft;
+	CharacterMovement->RollCooldownTicksLeft = Saved_RollCooldownTicksLeft;
+	// The climbing timer is started from the character's climbing tick between moves, moves saved before it can't rewind it
+	CharacterMovement->bReplayingStaleClimbingTimer = Saved_ClimbingTimerSerial != CharacterMovement->ClimbingTimerSerial;
+	if(!CharacterMovement->bReplayingStaleClimbingTimer)
+	{
+		CharacterMovement->ClimbingTimerTicksLeft = Saved_ClimbingTimerTicksLeft;
+	}
+	// Replaying the launching move starts the arc again from the corrected position
+	CharacterMovement->Safe_LaunchVelocity = Saved_LaunchVelocity;
+	CharacterMovement->Safe_LaunchDuration = Saved_LaunchDuration;
+}
+
+void UAdventureMovementComponent::FAdventureNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	const FSavedMove_Adventure& AdventureMove = static_cast<const FSavedMove_Adventure&>(ClientMove);
+	LedgeId = AdventureMove.Saved_LedgeId;
+	LaunchVelocity = AdventureMove.Saved_LaunchVelocity;
+	LaunchDuration = AdventureMove.Saved_LaunchDuration;
 }
 
-UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::FNetworkPredictionData_Client_Adventure(const UCharacterMovementComponent& ClientMovement)
+bool UAdventureMovementComponent::FAdventureNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	// The full 32 bits only while hanging
+	uint8 bHasLedge = LedgeId != 0;
+	Ar.SerializeBits(&bHasLedge, 1);
+	if(bHasLedge)
+	{
+		Ar << LedgeId;
+	}
+	else if(Ar.IsLoading())
+	{
+		LedgeId = 0;
+	}
+
+	uint8 bHasLaunch = LaunchDuration > 0.f;
+	Ar.SerializeBits(&bHasLaunch, 1);
+	if(bHasLaunch)
+	{
+		bool bLocalSuccess = true;
+		LaunchVelocity.NetSerialize(Ar, PackageMap, bLocalSuccess);
+		Ar << LaunchDuration;
+	}
+	else if(Ar.IsLoading())
+	{
+		LaunchVelocity = FVector::ZeroVector;
+		LaunchDuration = 0.f;
+	}
+
+	return !Ar.IsError();
+}
+
+UAdventureMovementComponent::FAdventureNetworkMoveDataContainer::FAdventureNetworkMoveDataContainer()
+{
+	NewMoveData = &MoveData[0];
+	PendingMoveData = &MoveData[1];
+	OldMoveData = &MoveData[2];
+}
+
+UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::FNetworkPredictionData_Client_Adventure(const UCharacterMovementComponent& ClientMovement, int32 FreeMoveCapacity)
 	: Super(ClientMovement)
 {
+	MaxFreeMoveCount = FMath::Max(FreeMoveCapacity, 0);
+	FreeMoves.Reserve(MaxFreeMoveCount);
 
+	bPrewarming = true;
+	while(FreeMoves.Num() < MaxFreeMoveCount)
+	{
+		FreeMoves.Push(AllocateNewMove());
+	}
+	bPrewarming = false;
 }
 
 FSavedMovePtr UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::AllocateNewMove()
 {
-	return FSavedMovePtr(new FSavedMove_Adventure());
+	if(!bPrewarming)
+	{
+		FallbackAllocations++;
+	}
+	NumMoves++;
+
+	// Move and reference count in one allocation
+	return MakeShared<FSavedMove_Adventure>();
+}
+
+FSavedMovePtr UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::CreateSavedMove()
+{
+	FSavedMovePtr Move = Super::CreateSavedMove();
+	HighWaterMark = FMath::Max(HighWaterMark, NumMoves - FreeMoves.Num());
+	return Move;
+}
+
+void UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::FreeMove(const FSavedMovePtr& Move)
+{
+	// A full free list drops the move, the base class keeps no other reference
+	if(Move.IsValid() && FreeMoves.Num() >= MaxFreeMoveCount)
+	{
+		NumMoves--;
+	}
+	Super::FreeMove(Move);
+}
+
+UAdventureMovementComponent::FSavedMovePoolStats UAdventureMovementComponent::FNetworkPredictionData_Client_Adventure::GetPoolStats() const
+{
+	FSavedMovePoolStats Stats;
+	Stats.Capacity = MaxFreeMoveCount;
+	Stats.InUse = NumMoves - FreeMoves.Num();
+	Stats.HighWaterMark = HighWaterMark;
+	Stats.FallbackAllocations = FallbackAllocations;
+	return Stats;
 }
 
 
@@ -78,6 +302,131 @@ void UAdventureMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
 	Safe_bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
 }
 
+void UAdventureMovementComponent::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	if(const FAdventureNetworkMoveData* MoveData = static_cast<const FAdventureNetworkMoveData*>(GetCurrentNetworkMoveData()))
+	{
+		UpdateClientLedge(MoveData->LedgeId, ClientTimeStamp);
+		if(MoveData->LaunchDuration > 0.f)
+		{
+			if(CanAcceptClientLaunch(MoveData->LaunchVelocity, MoveData->LaunchDuration))
+			{
+				Safe_LaunchVelocity = MoveData->LaunchVelocity;
+				Safe_LaunchDuration = MoveData->LaunchDuration;
+				bLoggedRejectedLaunch = false;
+			}
+			else
+			{
+				// The server doesn't launch, the client gets corrected back onto the ledge
+				if(!bLoggedRejectedLaunch)
+				{
+					UE_LOG(LogAdventureMovement, Warning, TEXT("%s: rejected launch %s over %.2fs"), *GetNameSafe(AdventureCharacterOwner), *MoveData->LaunchVelocity.ToCompactString(), MoveData->LaunchDuration);
+					bLoggedRejectedLaunch = true;
+				}
+				if(FAdventureMovementTelemetry::IsEnabled())
+				{
+					FAdventureMovementTelemetry::RecordFailedLaunch();
+				}
+			}
+		}
+	}
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+}
+
+void UAdventureMovementComponent::UpdateClientLedge(uint32 LedgeId, float ClientTimeStamp)
+{
+	if(LedgeId == ClientClaimedLedgeId || AdventureCharacterOwner == nullptr)
+	{
+		return;
+	}
+
+	if(LedgeId != 0)
+	{
+		// Check the claim where the client was when it sent the move, not where the server has it now
+		FAdventureMovementState ClaimState;
+		const FVector ClaimLocation = GetMovementStateAtTime(ClientTimeStamp, ClaimState) ? ClaimState.Location : UpdatedComponent->GetComponentLocation();
+
+		const ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+		const ALedge* Ledge = Registry ? Registry->ResolveLedge(LedgeId) : nullptr;
+		if(Ledge == nullptr || !CanReachLedgeFromHistory(ClientTimeStamp, Ledge->GetGrabBounds().GetClosestPointTo(ClaimLocation)))
+		{
+			if(RejectedLedgeId != LedgeId)
+			{
+				UE_LOG(LogAdventureMovement, Warning, TEXT("%s: rejected claim on ledge %08x"), *AdventureCharacterOwner->GetName(), LedgeId);
+				RejectedLedgeId = LedgeId;
+			}
+
+			// Later moves claiming it again get checked again, the history may back them up by then
+			ClientClaimedLedgeId = 0;
+			AdventureCharacterOwner->SetReplicatedLedgeId(0);
+			return;
+		}
+	}
+
+	ClientClaimedLedgeId = LedgeId;
+	RejectedLedgeId = 0;
+	AdventureCharacterOwner->SetReplicatedLedgeId(LedgeId);
+}
+
+bool UAdventureMovementComponent::CanAcceptClientLaunch(const FVector& LaunchVelocity, float LaunchDuration) const
+{
+	if(AdventureCharacterOwner == nullptr || LaunchDuration > MaxLaunchDuration || !IsCustomMovementMode(CMOVE_Climbing))
+	{
+		return false;
+	}
+
+	// The climbing state RPC and the launch move can arrive in either order
+	if(!AdventureCharacterOwner->IsClimbingState(CLIMB_HANGING) && !AdventureCharacterOwner->IsClimbingState(CLIMB_LAUNCHING))
+	{
+		return false;
+	}
+
+	// Slack for the velocity quantization of the move RPC
+	constexpr float SpeedTolerance = 1.f;
+	const UClimbingComponent* ClimbingComponent = AdventureCharacterOwner->GetClimbingComponent();
+	if(ClimbingComponent == nullptr || LaunchVelocity.Size() > ClimbingComponent->GetMaxClimbJumpSpeed() + SpeedTolerance)
+	{
+		return false;
+	}
+
+	// The jumps taken when nothing is in reach follow fixed arcs and end in a fall, they don't need a ledge
+	const UClimbingConfig& Config = ClimbingComponent->GetConfig();
+	const FVector Right = AdventureCharacterOwner->GetActorRightVector();
+	if(LaunchVelocity.Equals(FVector::UpVector * Config.MaxJumpUpVelocity, SpeedTolerance)
+		|| LaunchVelocity.Equals(ClimbingComponent->GetSideJumpFallbackVelocity(Right), SpeedTolerance)
+		|| LaunchVelocity.Equals(ClimbingComponent->GetSideJumpFallbackVelocity(-Right), SpeedTolerance))
+	{
+		return true;
+	}
+
+	// Any other launch aims at a ledge, where the arc ends has to be in a side jump from here and in grab reach of a registered ledge
+	const FVector Start = UpdatedComponent->GetComponentLocation();
+	const FVector Landing = Start + LaunchVelocity * LaunchDuration + 0.5f * FVector(0.f, 0.f, GetGravityZ()) * FMath::Square(LaunchDuration);
+	if(FVector::Dist(Start, Landing) > Config.MaxSideJumpDistance + MaxLedgeGrabReach)
+	{
+		return false;
+	}
+
+	const ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+	if(Registry == nullptr)
+	{
+		return false;
+	}
+
+	ULedgeRegistry::FLedgeList Ledges;
+	Registry->GatherLedges(FBox(Landing, Landing).ExpandBy(MaxLedgeGrabReach), Ledges);
+	for (const ALedge* Ledge : Ledges)
+	{
+		if(FVector::DistSquared(Ledge->GetGrabBounds().GetClosestPointTo(Landing), Landing) <= FMath::Square(MaxLedgeGrabReach))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 FNetworkPredictionData_Client* UAdventureMovementComponent::GetPredictionData_Client() const
 {
 	check(PawnOwner != nullptr);
@@ -86,20 +435,117 @@ FNetworkPredictionData_Client* UAdventureMovementComponent::GetPredictionData_Cl
 	{
 		UAdventureMovementComponent* MutableThis = const_cast<UAdventureMovementComponent*>(this);
 
-		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Adventure(*this);
-		MutableThis->ClientPredictionData->MaxSmoothNetUpdateDist = 92.f;
-		MutableThis->ClientPredictionData->NoSmoothNetUpdateDist = 140.f;
-
+		// Smoothing distances come from NetworkMaxSmoothUpdateDistance and NetworkNoSmoothUpdateDistance
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Adventure(*this, SavedMovePoolCapacity);
 	}
 
 	return ClientPredictionData;
 }
 
+void UAdventureMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+
+	TEnumAsByte<EMovementMode> ServerMode;
+	TEnumAsByte<EMovementMode> ServerGroundMode;
+	uint8 ServerCustomMode;
+	UnpackNetworkMovementMode(ServerMovementMode, ServerMode, ServerCustomMode, ServerGroundMode);
+
+	const FName ClientLabel = GetMovementModeLabel(MovementMode, CustomMovementMode);
+	const FName ServerLabel = GetMovementModeLabel(ServerMode, ServerCustomMode);
+	const FName Label = ClientLabel == ServerLabel ? ClientLabel : FName(*FString::Printf(TEXT("%s>%s"), *ClientLabel.ToString(), *ServerLabel.ToString()));
+	// The server corrected the move it acked, compare against where that move ended up on this client rather than
+	// the current location, which already includes the moves sent since
+	const FVector ClientLocation = ClientData.LastAckedMove.IsValid() ? ClientData.LastAckedMove->SavedLocation : UpdatedComponent->GetComponentLocation();
+	const float Distance = FVector::Dist(ClientLocation, NewLocation);
+
+	FAdventureCorrectionStats& Stats = CorrectionStats.FindOrAdd(Label);
+	Stats.Corrections++;
+	// Moves newer than the corrected one are still saved and get replayed on top of it
+	Stats.ResimulatedMoves += ClientData.SavedMoves.Num();
+	Stats.TotalDistance += Distance;
+	Stats.MaxDistance = FMath::Max(Stats.MaxDistance, Distance);
+}
+
+FName UAdventureMovementComponent::GetMovementModeLabel(uint8 InMovementMode, uint8 InCustomMode)
+{
+	if(InMovementMode == MOVE_Custom)
+	{
+		return FName(*StaticEnum<ECustomMovementMode>()->GetNameStringByValue(InCustomMode));
+	}
+
+	return FName(*StaticEnum<EMovementMode>()->GetNameStringByValue(InMovementMode));
+}
+
+bool UAdventureMovementComponent::GetSavedMovePoolStats(FSavedMovePoolStats& OutStats) const
+{
+	if(ClientPredictionData == nullptr)
+	{
+		return false;
+	}
+
+	OutStats = static_cast<const FNetworkPredictionData_Client_Adventure*>(ClientPredictionData)->GetPoolStats();
+	return true;
+}
+
+void UAdventureMovementComponent::RunSavedMovePoolBenchmark(int32 PoolCapacity, int32 NumMoves)
+{
+	// Moves stay queued until the server acks them, 96 in flight is 400 ms of round trip at 240 Hz
+	constexpr int32 MovesInFlight = 96;
+	const UAdventureMovementComponent& Defaults = *GetDefault<UAdventureMovementComponent>();
+	auto RunPass = [NumMoves, &Defaults](int32 Capacity, uint64& OutAllocations, FSavedMovePoolStats& OutStats)
+	{
+		FNetworkPredictionData_Client_Adventure ClientData(Defaults, Capacity);
+		TArray<FSavedMovePtr> InFlight;
+		InFlight.SetNum(MovesInFlight);
+
+		const uint64 StartAllocations = FAdventureMovementTelemetry::GetAllocationCount();
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for(int32 MoveIndex = 0; MoveIndex < NumMoves; MoveIndex++)
+		{
+			// Acking the oldest move frees it before the next one is saved
+			FSavedMovePtr& Move = InFlight[MoveIndex % MovesInFlight];
+			ClientData.FreeMove(Move);
+			Move = ClientData.CreateSavedMove();
+		}
+		const double Ms = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+		OutAllocations = FAdventureMovementTelemetry::GetAllocationCount() - StartAllocations;
+		OutStats = ClientData.GetPoolStats();
+		return Ms;
+	};
+
+	// No free list is what a plain AllocateNewMove override gets once the engine's default free list is full
+	uint64 HeapAllocations, PoolAllocations;
+	FSavedMovePoolStats HeapStats, Stats;
+	const double HeapMs = RunPass(0, HeapAllocations, HeapStats);
+	const double PoolMs = RunPass(PoolCapacity, PoolAllocations, Stats);
+
+	const double NumMovesDiv = FMath::Max(NumMoves, 1);
+	UE_LOG(LogAdventureMovement, Log, TEXT("Saved move benchmark, %d moves: no free list %.3f ms (%.1f ns/move, %.2f allocations/move), free list %.3f ms (%.1f ns/move, %llu allocations), capacity %d, high water %d, fallbacks %d"),
+		NumMoves, HeapMs, HeapMs * 1e6 / NumMovesDiv, HeapAllocations / NumMovesDiv, PoolMs, PoolMs * 1e6 / NumMovesDiv, PoolAllocations,
+		Stats.Capacity, Stats.HighWaterMark, Stats.FallbackAllocations);
+#if !UE_BUILD_SHIPPING
+	// Allocations are counted process wide, other threads can add a few
+	if(PoolCapacity >= MovesInFlight && PoolAllocations > 0)
+	{
+		UE_LOG(LogAdventureMovement, Warning, TEXT("Saved move benchmark: %llu allocations with a free list covering every move in flight"), PoolAllocations);
+	}
+#endif
+}
+
 #pragma endregion 
 
 UAdventureMovementComponent::UAdventureMovementComponent()
 {
 	NavAgentProps.bCanCrouch = true;
+
+	NetworkMaxSmoothUpdateDistance = 92.f;
+	NetworkNoSmoothUpdateDistance = 140.f;
+
+	SetNetworkMoveDataContainer(AdventureMoveDataContainer);
+
+	// Resolved again on register, until then the class defaults stand in
+	Config = GetDefault<UAdventureMovementConfig>();
 }
 
 void UAdventureMovementComponent::InitializeComponent()
@@ -108,6 +554,50 @@ void UAdventureMovementComponent::InitializeComponent()
 	AdventureCharacterOwner = Cast<AShooterAdventureCharacter>(GetOwner());
 }
 
+void UAdventureMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	SetSimulationClock(bUseFixedTimestep, bUseAsyncPhysicsClock);
+}
+
+void UAdventureMovementComponent::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Tuning saved on the component before UAdventureMovementConfig existed
+	if(MovementConfig == nullptr)
+	{
+		MovementConfig = MigrateDeprecatedConfig<UAdventureMovementConfig>(this);
+		if(MovementConfig != nullptr)
+		{
+			UE_LOG(LogAdventureMovement, Warning, TEXT("%s: moved deprecated tuning into %s, resave the asset or point it at a shared config"), *GetPathName(), *MovementConfig->GetName());
+		}
+	}
+#endif
+}
+
+void UAdventureMovementComponent::OnRegister()
+{
+	Super::OnRegister();
+	Config = MovementConfig != nullptr ? MovementConfig.Get() : GetDefault<UAdventureMovementConfig>();
+}
+
+void UAdventureMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if(AdventureCharacterOwner)
+	{
+		AdventureCharacterOwner->PublishAnimSnapshot();
+
+		if(FAdventureMovementTelemetry::IsEnabled())
+		{
+			FAdventureMovementTelemetry::RecordCharacterFrame(MovementMode, CustomMovementMode, AdventureCharacterOwner->GetClimbingState());
+		}
+	}
+}
+
 #pragma region Slide
 
 void UAdventureMovementComponent::EnterSlide()
@@ -115,7 +605,7 @@ void UAdventureMovementComponent::EnterSlide()
 	bWantsToCrouch = true;
 	bCrouchMaintainsBaseLocation = true;
 	
-	Velocity += Velocity.GetSafeNormal2D() * Slide_EnterImpulse;
+	Velocity += Velocity.GetSafeNormal2D() * Config->Slide_EnterImpulse;
 	SetMovementMode(MOVE_Custom, CMOVE_Slide);
 }
 
@@ -148,7 +638,7 @@ void UAdventureMovementComponent::PhysSlide(float deltaTime, int32 Iterations)
 	}
 
 	// Surface gravity
-	Velocity += Slide_GravityForce * deltaTime * FVector::DownVector;
+	Velocity += Config->Slide_GravityForce * deltaTime * FVector::DownVector;
 
 	// Strafe
 	// check if player has pressed horizontal input enough to make character moves right or left
@@ -164,7 +654,7 @@ void UAdventureMovementComponent::PhysSlide(float deltaTime, int32 Iterations)
 
 	if(!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
 	{
-		CalcVelocity(deltaTime, Slide_Friction, false, GetMaxBrakingDeceleration());
+		CalcVelocity(deltaTime, Config->Slide_Friction, false, GetMaxBrakingDeceleration());
 	}
 	ApplyRootMotionToVelocity(deltaTime);
 
@@ -220,7 +710,7 @@ void UAdventureMovementComponent::EnterRoll(EMovementMode PreviousMovementMode,
 	bCrouchMaintainsBaseLocation = true;
 	
 	RollDirection = Acceleration.GetSafeNormal2D().IsNearlyZero() ? CharacterOwner->GetActorForwardVector() : Acceleration.GetSafeNormal2D();
-	RollTime = RollTimeDuration;
+	RollTicksLeft = SecondsToSimTicks(Config->RollTimeDuration);
 
 	FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, true, nullptr);
 }
@@ -228,14 +718,12 @@ void UAdventureMovementComponent::EnterRoll(EMovementMode PreviousMovementMode,
 void UAdventureMovementComponent::ExitRoll()
 {
 	bWantsToCrouch = false;
-	bHasRollRecently = true;
+	RollCooldownTicksLeft = SecondsToSimTicks(Config->RollDelayBetweenRolls);
 
 	const FQuat NewRotation = FRotationMatrix::MakeFromXZ(UpdatedComponent->GetForwardVector().GetSafeNormal2D(),
 															FVector::UpVector).ToQuat();
 	FHitResult Hit;
 	SafeMoveUpdatedComponent(FVector::ZeroVector, NewRotation, true, Hit);
-
-	GetWorld()->GetTimerManager().SetTimer(RollResetTimerHandle, this, &UAdventureMovementComponent::ResetRoll, RollDelayBetweenRolls);
 }
 
 void UAdventureMovementComponent::PhysRoll(float deltaTime, int32 Iterations)
@@ -245,8 +733,7 @@ void UAdventureMovementComponent::PhysRoll(float deltaTime, int32 Iterations)
 		return;
 	}
 
-	RollTime -= deltaTime;
-	if(RollTime <= 0)
+	if(RollTicksLeft <= 0)
 	{
 		SetMovementMode(MOVE_Walking);
 		return;
@@ -300,7 +787,7 @@ void UAdventureMovementComponent::PhysRoll(float deltaTime, int32 Iterations)
 		}
 
 		// Compute move parameters
-		const FVector MoveVelocity = RollDirection * MaxRollSpeed;
+		const FVector MoveVelocity = RollDirection * Config->MaxRollSpeed;
 		const FVector Delta = timeTick * MoveVelocity;
 		const bool bZeroDelta = Delta.IsNearlyZero();
 		FStepDownResult StepDownResult;
@@ -454,12 +941,7 @@ void UAdventureMovementComponent::PhysRoll(float deltaTime, int32 Iterations)
 
 bool UAdventureMovementComponent::CanRoll() const
 {
-	return !bHasRollRecently && MovementMode == MOVE_Walking;
-}
-
-void UAdventureMovementComponent::ResetRoll()
-{
-	bHasRollRecently = false;
+	return RollCooldownTicksLeft <= 0 && MovementMode == MOVE_Walking;
 }
 
 void UAdventureMovementComponent::Server_EnterRoll_Implementation()
@@ -471,6 +953,59 @@ void UAdventureMovementComponent::Server_EnterRoll_Implementation()
 
 #pragma region Climbing
 
+void UAdventureMovementComponent::SetClimbingTimer(float Duration)
+{
+	ClimbingTimerTicksLeft = SecondsToSimTicks(Duration);
+	ClimbingTimerSerial++;
+}
+
+void UAdventureMovementComponent::ClearClimbingTimer()
+{
+	ClimbingTimerTicksLeft = 0;
+	ClimbingTimerSerial++;
+}
+
+const FName UAdventureMovementComponent::LaunchRootMotionName(TEXT("AdventureLaunch"));
+
+void UAdventureMovementComponent::LaunchAlongArc(const FVector& LaunchVelocity, float Duration)
+{
+	if(Duration <= 0.f)
+	{
+		Launch(LaunchVelocity);
+		return;
+	}
+
+	// Snapped to the precision the move RPC sends, so the server builds the same arc
+	Safe_LaunchVelocity = LaunchVelocity.GridSnap(0.1f);
+	Safe_LaunchDuration = Duration;
+}
+
+void UAdventureMovementComponent::StopLaunch()
+{
+	Safe_LaunchDuration = 0.f;
+	RemoveRootMotionSource(LaunchRootMotionName);
+}
+
+void UAdventureMovementComponent::ApplyPendingLaunch()
+{
+	if(Safe_LaunchDuration <= 0.f)
+	{
+		return;
+	}
+
+	TSharedPtr<FRootMotionSource_AdventureLaunch> LaunchSource = MakeShared<FRootMotionSource_AdventureLaunch>();
+	LaunchSource->InstanceName = LaunchRootMotionName;
+	LaunchSource->SetArc(UpdatedComponent->GetComponentLocation(), Safe_LaunchVelocity, GetGravityZ(), Safe_LaunchDuration);
+	// Falling takes over with the arc's end velocity and carries on along the same parabola
+	LaunchSource->FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::SetVelocity;
+	LaunchSource->FinishVelocityParams.SetVelocity = LaunchSource->GetVelocityAtTime(Safe_LaunchDuration);
+	Safe_LaunchDuration = 0.f;
+
+	RemoveRootMotionSource(LaunchRootMotionName);
+	SetMovementMode(MOVE_Falling);
+	ApplyRootMotionSource(LaunchSource);
+}
+
 void UAdventureMovementComponent::PhysClimbing(float deltaTime, int32 Iterations)
 {
 	if (deltaTime < MIN_TICK_TIME)
@@ -480,7 +1015,6 @@ void UAdventureMovementComponent::PhysClimbing(float deltaTime, int32 Iterations
 
 	if(AdventureCharacterOwner->IsClimbingState(CLIMB_LAUNCHING))
 	{
-		GEngine->AddOnScreenDebugMessage(4, 0, FColor::Red, TEXT("PhysClimbing: Character is launching"));
 		return;
 	}
 	
@@ -558,6 +1092,215 @@ void UAdventureMovementComponent::PhysClimbing(float deltaTime, int32 Iterations
 
 #pragma endregion
 
+#pragma region Fixed Timestep
+
+int32 UAdventureMovementComponent::SecondsToSimTicks(float Seconds) const
+{
+	return FMath::Max(1, FMath::CeilToInt(Seconds * SimTickRate));
+}
+
+void UAdventureMovementComponent::SetSimulationClock(bool bFixedTimestep, bool bAsyncPhysicsClock)
+{
+	bUseFixedTimestep = bFixedTimestep;
+	bUseAsyncPhysicsClock = bAsyncPhysicsClock;
+
+	const UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	bAsyncPhysicsClockActive = bUseFixedTimestep && bUseAsyncPhysicsClock && PhysicsSettings->bTickPhysicsAsync;
+	if(bUseFixedTimestep && bUseAsyncPhysicsClock && !bAsyncPhysicsClockActive)
+	{
+		UE_LOG(LogAdventureMovement, Warning, TEXT("%s: async physics clock needs Tick Physics Async, using fixed steps from the move delta"), *GetNameSafe(GetOwner()));
+	}
+
+	// Client and server read the same project settings, so predicted pawns still agree on the step.
+	// FixedTickRate stays as configured for when the clock is switched back
+	SimTickRate = bAsyncPhysicsClockActive ? FMath::Max(1, FMath::RoundToInt(1.f / PhysicsSettings->AsyncFixedTimeStepSize)) : FixedTickRate;
+
+	AsyncPhysicsSteps.store(0, std::memory_order_relaxed);
+	SetAsyncPhysicsTickEnabled(bAsyncPhysicsClockActive);
+}
+
+bool UAdventureMovementComponent::UsesAsyncPhysicsClock() const
+{
+	// A remote client predicts autonomous proxies, their steps have to come from the move they sent
+	return bAsyncPhysicsClockActive && CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_Authority
+		&& CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy;
+}
+
+void UAdventureMovementComponent::AsyncPhysicsTickComponent(float DeltaTime, float SimTime)
+{
+	// Physics thread, only the step count crosses over. The custom modes can't run here, see bUseAsyncPhysicsClock
+	Super::AsyncPhysicsTickComponent(DeltaTime, SimTime);
+	AsyncPhysicsSteps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UAdventureMovementComponent::AdvanceSimulationClock(float DeltaSeconds)
+{
+	const float Step = GetSimulationTimeStep();
+	int32 Ticks;
+	if(UsesAsyncPhysicsClock())
+	{
+		// Steps come from the physics thread, the accumulator only feeds mesh interpolation
+		Ticks = AsyncPhysicsSteps.exchange(0, std::memory_order_relaxed);
+		SimTimeAccumulator = FMath::Fmod(SimTimeAccumulator + DeltaSeconds, Step);
+	}
+	else
+	{
+		SimTimeAccumulator += DeltaSeconds;
+		Ticks = FMath::FloorToInt(SimTimeAccumulator / Step);
+		SimTimeAccumulator -= Ticks * Step;
+	}
+
+	// Ticks above the cap are dropped so a long hitch can't spiral
+	PendingSimTicks = FMath::Min(Ticks, MaxSimTicksPerMove);
+	for(int32 Tick = 0; Tick < PendingSimTicks; Tick++)
+	{
+		SimulationTick++;
+		TickSimulationTimers();
+	}
+}
+
+void UAdventureMovementComponent::TickSimulationTimers()
+{
+	if(RollTicksLeft > 0)
+	{
+		RollTicksLeft--;
+	}
+
+	if(RollCooldownTicksLeft > 0)
+	{
+		RollCooldownTicksLeft--;
+	}
+
+	// Replays rewind the timer through the saved move and count it down again. A timer that expired bumped the serial,
+	// so moves saved before the expiry can't fire it a second time.
+	if(ClimbingTimerTicksLeft > 0 && !(bClientUpdating && bReplayingStaleClimbingTimer))
+	{
+		ClimbingTimerTicksLeft--;
+		if(ClimbingTimerTicksLeft == 0)
+		{
+			ClimbingTimerSerial++;
+			if(AdventureCharacterOwner)
+			{
+				AdventureCharacterOwner->FinishClimbingTimer();
+			}
+		}
+	}
+}
+
+void UAdventureMovementComponent::PhysCustomFixed(float deltaTime, int32 Iterations)
+{
+	const float Step = GetSimulationTimeStep();
+	int32 Steps = PendingSimTicks;
+	PendingSimTicks = 0;
+	if(!UsesAsyncPhysicsClock())
+	{
+		// Step on the time actually spent in the custom mode, what doesn't fill a step waits for the next update
+		StepTimeAccumulator += deltaTime;
+		Steps = FMath::FloorToInt(StepTimeAccumulator / Step);
+		StepTimeAccumulator -= Steps * Step;
+		Steps = FMath::Min(Steps, MaxSimTicksPerMove);
+	}
+	INC_DWORD_STAT_BY(STAT_AdventureFixedSteps, Steps);
+
+	while(Steps > 0)
+	{
+		Steps--;
+		PreviousStepLocation = UpdatedComponent->GetComponentLocation();
+		PhysCustomMode(Step, Iterations);
+
+		if(MovementMode != MOVE_Custom)
+		{
+			// Hand the rest of the move, carried time included, to the new mode
+			const float RemainingTime = Steps * Step + StepTimeAccumulator;
+			StepTimeAccumulator = 0.f;
+			StartNewPhysics(RemainingTime, Iterations);
+			return;
+		}
+	}
+}
+
+void UAdventureMovementComponent::UpdateFixedStepInterpolation()
+{
+	// Proxies and remote clients on a listen server already get their mesh from the engine's network smoothing
+	USkeletalMeshComponent* Mesh = CharacterOwner->GetMesh();
+	if(Mesh == nullptr || !CharacterOwner->IsLocallyControlled() || IsNetMode(NM_DedicatedServer))
+	{
+		return;
+	}
+
+	const bool bInterpolate = bUseFixedTimestep && MovementMode == MOVE_Custom;
+	if(!bInterpolate && !bMeshStepOffsetApplied)
+	{
+		// Leave the mesh to crouching and the engine as soon as the offset is cleared
+		return;
+	}
+
+	// Render one step behind, blending between the last two fixed steps. The offset sits on top of the base
+	// translation like the smoothing offset does, so crouch adjustments of the base are kept.
+	FVector WorldOffset = FVector::ZeroVector;
+	if(bInterpolate)
+	{
+		const float Alpha = (UsesAsyncPhysicsClock() ? SimTimeAccumulator : StepTimeAccumulator) / GetSimulationTimeStep();
+		const FVector CurrentLocation = UpdatedComponent->GetComponentLocation();
+		WorldOffset = FMath::Lerp(PreviousStepLocation, CurrentLocation, Alpha) - CurrentLocation;
+	}
+
+	const FVector LocalOffset = UpdatedComponent->GetComponentTransform().InverseTransformVectorNoScale(WorldOffset);
+	Mesh->SetRelativeLocation(CharacterOwner->GetBaseTranslationOffset() + LocalOffset);
+	bMeshStepOffsetApplied = bInterpolate;
+}
+
+#pragma endregion
+
+#pragma region History
+
+void UAdventureMovementComponent::RecordMovementHistory()
+{
+	if(!bRecordMovementHistory || !CharacterOwner->HasAuthority())
+	{
+		return;
+	}
+
+	if(MovementHistory.GetCapacity() == 0)
+	{
+		MovementHistory.Init(MovementHistoryCapacity);
+	}
+
+	// Remote clients claim in their own move time, so their history is recorded on the same clock
+	float Timestamp = GetWorld()->GetTimeSeconds();
+	if(!CharacterOwner->IsLocallyControlled() && CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy && HasPredictionData_Server())
+	{
+		Timestamp = GetPredictionData_Server_Character()->CurrentClientTimeStamp;
+	}
+
+	// Client time stamps are reset periodically, samples from before the reset can't be compared anymore
+	if(!MovementHistory.IsEmpty() && Timestamp < MovementHistory.GetNewestTime() - HistoryRewindTolerance)
+	{
+		MovementHistory.Reset();
+	}
+
+	const uint8 ClimbingState = AdventureCharacterOwner ? static_cast<uint8>(AdventureCharacterOwner->GetClimbingState()) : 0;
+	MovementHistory.Add(Timestamp, UpdatedComponent->GetComponentLocation(), Velocity, MovementMode, CustomMovementMode, ClimbingState);
+}
+
+bool UAdventureMovementComponent::GetMovementStateAtTime(float Time, FAdventureMovementState& OutState) const
+{
+	return MovementHistory.GetStateAtTime(Time, OutState);
+}
+
+bool UAdventureMovementComponent::CanReachLedgeFromHistory(float ClaimTime, const FVector& GrabLocation) const
+{
+	if(MovementHistory.IsEmpty())
+	{
+		// Nothing recorded yet, only trust claims that are in reach right now
+		return FVector::DistSquared(UpdatedComponent->GetComponentLocation(), GrabLocation) <= FMath::Square(MaxLedgeGrabReach);
+	}
+
+	return MovementHistory.WasWithinRadius(ClaimTime - HistoryRewindTolerance, ClaimTime + HistoryRewindTolerance, GrabLocation, MaxLedgeGrabReach);
+}
+
+#pragma endregion
+
 #pragma region Movement overwritten Helper Functions
 bool UAdventureMovementComponent::IsMovingOnGround() const
 {
@@ -573,7 +1316,7 @@ bool UAdventureMovementComponent::CanWalkOffLedges() const
 {
 	if(IsCrouching() && IsCustomMovementMode(CMOVE_Roll))
 	{
-		return bCanWalkOffLedgeWhenRolling;
+		return Config->bCanWalkOffLedgeWhenRolling;
 	}
 	
 	return Super::CanWalkOffLedges();
@@ -583,7 +1326,7 @@ float UAdventureMovementComponent::GetMaxSpeed() const
 {
 	if(MovementMode == MOVE_Walking && Safe_bWantsToSprint && !IsCrouching())
 	{
-		return MaxSprintSpeed;
+		return Config->MaxSprintSpeed;
 	}
 
 	if(MovementMode != MOVE_Custom)
@@ -594,13 +1337,13 @@ float UAdventureMovementComponent::GetMaxSpeed() const
 	switch (CustomMovementMode)
 	{
 	case CMOVE_Slide:
-		return MaxSlideSpeed;
+		return Config->MaxSlideSpeed;
 	case  CMOVE_Roll:
-		return MaxRollSpeed;
+		return Config->MaxRollSpeed;
 	case CMOVE_Climbing:
 		return 0.f;
 	default:
-		UE_LOG(LogTemp, Fatal, TEXT("Invalid custom movement mode"));
+		UE_LOG(LogAdventureMovement, Fatal, TEXT("Invalid custom movement mode"));
 		return -1.f;
 	}
 }
@@ -615,13 +1358,13 @@ float UAdventureMovementComponent::GetMaxBrakingDeceleration() const
 	switch (CustomMovementMode)
 	{
 	case CMOVE_Slide:
-		return BrakingDecelerationSliding;
+		return Config->BrakingDecelerationSliding;
 	case  CMOVE_Roll:
-		return BrakingDecelerationRolling;
+		return Config->BrakingDecelerationRolling;
 	case CMOVE_Climbing:
 		return BrakingDecelerationFlying;
 	default:
-		UE_LOG(LogTemp, Fatal, TEXT("Invalid custom movement mode"));
+		UE_LOG(LogAdventureMovement, Fatal, TEXT("Invalid custom movement mode"));
 		return -1.f;
 	}
 }
@@ -641,6 +1384,8 @@ void UAdventureMovementComponent::PhysicsRotation(float DeltaTime)
 void UAdventureMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
 {
 	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+	AdvanceSimulationClock(DeltaSeconds);
+	ApplyPendingLaunch();
 
 	if(Safe_bWantsToRoll)
 	{
@@ -664,6 +1409,8 @@ void UAdventureMovementComponent::OnMovementUpdated(float DeltaSeconds, const FV
 	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
 
 	Safe_bPreviousWantsToCrouch = bWantsToCrouch;
+	UpdateFixedStepInterpolation();
+	RecordMovementHistory();
 }
 
 void UAdventureMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeconds)
@@ -673,8 +1420,20 @@ void UAdventureMovementComponent::UpdateCharacterStateAfterMovement(float DeltaS
 
 void UAdventureMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AdventureCustomPhysics);
 	Super::PhysCustom(deltaTime, Iterations);
 
+	if(bUseFixedTimestep)
+	{
+		PhysCustomFixed(deltaTime, Iterations);
+		return;
+	}
+
+	PhysCustomMode(deltaTime, Iterations);
+}
+
+void UAdventureMovementComponent::PhysCustomMode(float deltaTime, int32 Iterations)
+{
 	switch (CustomMovementMode)
 	{
 	case CMOVE_Slide:
@@ -687,13 +1446,23 @@ void UAdventureMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
 		PhysClimbing(deltaTime, Iterations);
 		break;;
 	default:
-		UE_LOG(LogTemp, Fatal, TEXT("Invalid Custom Movement Mode"));
+		UE_LOG(LogAdventureMovement, Fatal, TEXT("Invalid Custom Movement Mode"));
 	}
 }
 
 void UAdventureMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
 {	
 	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+	PreviousStepLocation = UpdatedComponent->GetComponentLocation();
+	if(PreviousMovementMode != MOVE_Custom)
+	{
+		StepTimeAccumulator = 0.f;
+	}
+
+	if(FAdventureMovementTelemetry::IsEnabled())
+	{
+		FAdventureMovementTelemetry::RecordModeTransition(PreviousMovementMode, PreviousCustomMode, MovementMode, CustomMovementMode);
+	}
 	
 	if(PreviousMovementMode == MOVE_Custom && PreviousCustomMode == CMOVE_Roll)
 	{
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureMovementHistory.h"
+
+static_assert(sizeof(FAdventureMovementSample) == 24, "Movement samples should stay compact");
+
+namespace AdventureMovementHistory
+{
+	constexpr float LocationScale = 10.f;
+
+	int32 QuantizeLocation(double Value)
+	{
+		return FMath::RoundToInt32(FMath::Clamp(Value * LocationScale, (double)MIN_int32, (double)MAX_int32));
+	}
+
+	int16 QuantizeVelocity(double Value)
+	{
+		return static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(Value), (int32)MIN_int16, (int32)MAX_int16));
+	}
+}
+
+void FAdventureMovementHistory::Init(int32 InCapacity)
+{
+	const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2));
+	Timestamps.SetNumZeroed(Capacity);
+	Samples.SetNumZeroed(Capacity);
+	Mask = Capacity - 1;
+	Reset();
+}
+
+void FAdventureMovementHistory::Reset()
+{
+	Head = 0;
+	Count = 0;
+}
+
+void FAdventureMovementHistory::Add(float Timestamp, const FVector& Location, const FVector& Velocity, uint8 MovementMode, uint8 CustomMovementMode, uint8 ClimbingState)
+{
+	if(Timestamps.Num() == 0)
+	{
+		return;
+	}
+
+	int32 Slot;
+	if(Count > 0 && Timestamp <= GetNewestTime())
+	{
+		// Several moves can be processed in the same frame, keep the latest one so timestamps stay strictly increasing
+		Slot = ToPhysical(Count - 1);
+		Timestamp = GetNewestTime();
+	}
+	else if(Count < Timestamps.Num())
+	{
+		Slot = ToPhysical(Count);
+		Count++;
+	}
+	else
+	{
+		Slot = Head;
+		Head = (Head + 1) & Mask;
+	}
+
+	using namespace AdventureMovementHistory;
+	FAdventureMovementSample& Sample = Samples[Slot];
+	Sample.Location[0] = QuantizeLocation(Location.X);
+	Sample.Location[1] = QuantizeLocation(Location.Y);
+	Sample.Location[2] = QuantizeLocation(Location.Z);
+	Sample.Velocity[0] = QuantizeVelocity(Velocity.X);
+	Sample.Velocity[1] = QuantizeVelocity(Velocity.Y);
+	Sample.Velocity[2] = QuantizeVelocity(Velocity.Z);
+	Sample.MovementMode = MovementMode;
+	Sample.CustomMovementMode = CustomMovementMode;
+	Sample.ClimbingState = ClimbingState;
+	Timestamps[Slot] = Timestamp;
+}
+
+FVector FAdventureMovementHistory::DecodeLocation(const FAdventureMovementSample& Sample) const
+{
+	return FVector(Sample.Location[0], Sample.Location[1], Sample.Location[2]) / AdventureMovementHistory::LocationScale;
+}
+
+FAdventureMovementState FAdventureMovementHistory::GetState(int32 Index) const
+{
+	check(Index >= 0 && Index < Count);
+
+	const int32 Slot = ToPhysical(Index);
+	const FAdventureMovementSample& Sample = Samples[Slot];
+
+	FAdventureMovementState State;
+	State.Timestamp = Timestamps[Slot];
+	State.Location = DecodeLocation(Sample);
+	State.Velocity = FVector(Sample.Velocity[0], Sample.Velocity[1], Sample.Velocity[2]);
+	State.MovementMode = Sample.MovementMode;
+	State.CustomMovementMode = Sample.CustomMovementMode;
+	State.ClimbingState = Sample.ClimbingState;
+	return State;
+}
+
+int32 FAdventureMovementHistory::FindIndexAtTime(float Time) const
+{
+	if(Count == 0 || Time < GetOldestTime())
+	{
+		return INDEX_NONE;
+	}
+
+	// Upper bound over the logical order, the buffer is sorted by time from Head
+	int32 Low = 0;
+	int32 High = Count;
+	while(Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if(Timestamps[ToPhysical(Mid)] <= Time)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	return Low - 1;
+}
+
+bool FAdventureMovementHistory::GetStateAtTime(float Time, FAdventureMovementState& OutState) const
+{
+	const int32 Index = FindIndexAtTime(Time);
+	if(Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutState = GetState(Index);
+	if(Index + 1 < Count)
+	{
+		const FAdventureMovementState Next = GetState(Index + 1);
+		const float Alpha = (Time - OutState.Timestamp) / FMath::Max(Next.Timestamp - OutState.Timestamp, UE_KINDA_SMALL_NUMBER);
+		OutState.Location = FMath::Lerp(OutState.Location, Next.Location, Alpha);
+		OutState.Velocity = FMath::Lerp(OutState.Velocity, Next.Velocity, Alpha);
+		OutState.Timestamp = Time;
+	}
+
+	return true;
+}
+
+bool FAdventureMovementHistory::WasWithinRadius(float StartTime, float EndTime, const FVector& Location, float Radius) const
+{
+	if(Count == 0)
+	{
+		return false;
+	}
+
+	const float RadiusSquared = Radius * Radius;
+	for(int32 Index = FMath::Max(FindIndexAtTime(StartTime), 0); Index < Count; Index++)
+	{
+		const int32 Slot = ToPhysical(Index);
+		if(Timestamps[Slot] > EndTime)
+		{
+			break;
+		}
+
+		if(FVector::DistSquared(DecodeLocation(Samples[Slot]), Location) <= RadiusSquared)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+SIZE_T FAdventureMovementHistory::GetAllocatedSize() const
+{
+	return Timestamps.GetAllocatedSize() + Samples.GetAllocatedSize();
+}
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureMovementTelemetry.h"
+
+#include "AdventureMovementComponent.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ShooterAdventure/ShooterAdventureCharacter.h"
+
+CSV_DEFINE_CATEGORY(AdventureMovement, true);
+CSV_DEFINE_CATEGORY(AdventureClimbing, true);
+
+bool FAdventureMovementTelemetry::bEnabled = false;
+FAdventureMovementTelemetry::FCounters FAdventureMovementTelemetry::Frame;
+FAdventureMovementTelemetry::FTotals FAdventureMovementTelemetry::Totals;
+FDelegateHandle FAdventureMovementTelemetry::EndFrameHandle;
+
+static FAutoConsoleVariableRef CVarMovementTelemetry(
+	TEXT("Adventure.MovementTelemetry"),
+	FAdventureMovementTelemetry::bEnabled,
+	TEXT("Records per-frame movement mode, climbing state, transition, failed launch and scene query counts."),
+	FConsoleVariableDelegate::CreateStatic(&FAdventureMovementTelemetry::OnEnabledChanged));
+
+static FAutoConsoleCommand MovementTelemetryReportCommand(
+	TEXT("Adventure.MovementTelemetry.Report"),
+	TEXT("Writes time in mode, transition histograms and scene queries per mode since the last reset to Saved/Profiling/MovementTelemetry.csv"),
+	FConsoleCommandDelegate::CreateStatic(&FAdventureMovementTelemetry::WriteReport));
+
+static FAutoConsoleCommand MovementTelemetryResetCommand(
+	TEXT("Adventure.MovementTelemetry.Reset"),
+	TEXT("Clears the accumulated movement telemetry"),
+	FConsoleCommandDelegate::CreateStatic(&FAdventureMovementTelemetry::Reset));
+
+namespace AdventureMovementTelemetry
+{
+	const TCHAR* ModeNames[] = { TEXT("Other"), TEXT("Walking"), TEXT("Falling"), TEXT("Swimming"), TEXT("Flying"), TEXT("Slide"), TEXT("Roll"), TEXT("Climbing") };
+	static_assert(UE_ARRAY_COUNT(ModeNames) == FAdventureMovementTelemetry::NumModes, "Every telemetry mode needs a name");
+
+	FString GetClimbingStateName(int32 State)
+	{
+		return StaticEnum<EClimbingState>()->GetNameStringByValue(State);
+	}
+}
+
+EAdventureTelemetryMode FAdventureMovementTelemetry::GetMode(uint8 MovementMode, uint8 CustomMode)
+{
+	switch (MovementMode)
+	{
+	case MOVE_Walking:
+	case MOVE_NavWalking:
+		return EAdventureTelemetryMode::Walking;
+	case MOVE_Falling:
+		return EAdventureTelemetryMode::Falling;
+	case MOVE_Swimming:
+		return EAdventureTelemetryMode::Swimming;
+	case MOVE_Flying:
+		return EAdventureTelemetryMode::Flying;
+	case MOVE_Custom:
+		switch (CustomMode)
+		{
+		case CMOVE_Slide:
+			return EAdventureTelemetryMode::Slide;
+		case CMOVE_Roll:
+			return EAdventureTelemetryMode::Roll;
+		case CMOVE_Climbing:
+			return EAdventureTelemetryMode::Climbing;
+		default:
+			return EAdventureTelemetryMode::Other;
+		}
+	default:
+		return EAdventureTelemetryMode::Other;
+	}
+}
+
+void FAdventureMovementTelemetry::RecordCharacterFrame(uint8 MovementMode, uint8 CustomMode, uint8 ClimbingState)
+{
+	FPlatformAtomics::InterlockedIncrement(&Frame.Modes[(int32)GetMode(MovementMode, CustomMode)]);
+	FPlatformAtomics::InterlockedIncrement(&Frame.ClimbingStates[ClimbingState % NumClimbingStates]);
+}
+
+void FAdventureMovementTelemetry::RecordModeTransition(uint8 PreviousMovementMode, uint8 PreviousCustomMode, uint8 MovementMode, uint8 CustomMode)
+{
+	FPlatformAtomics::InterlockedIncrement(&Frame.ModeTransitions);
+	FPlatformAtomics::InterlockedIncrement(&Totals.ModeTransitions[(int32)GetMode(PreviousMovementMode, PreviousCustomMode)][(int32)GetMode(MovementMode, CustomMode)]);
+}
+
+void FAdventureMovementTelemetry::RecordClimbingTransition(uint8 PreviousState, uint8 NewState)
+{
+	FPlatformAtomics::InterlockedIncrement(&Frame.ClimbingTransitions);
+	FPlatformAtomics::InterlockedIncrement(&Totals.ClimbingTransitions[PreviousState % NumClimbingStates][NewState % NumClimbingStates]);
+}
+
+void FAdventureMovementTelemetry::RecordSceneQuery(uint8 MovementMode, uint8 CustomMode)
+{
+	// Climbing probe batch workers record too, the frame is only read on the game thread once they are done
+	FPlatformAtomics::InterlockedIncrement(&Frame.SceneQueries[(int32)GetMode(MovementMode, CustomMode)]);
+}
+
+void FAdventureMovementTelemetry::RecordFailedLaunch()
+{
+	FPlatformAtomics::InterlockedIncrement(&Frame.FailedLaunches);
+}
+
+void FAdventureMovementTelemetry::RecordFailedHopUp()
+{
+	FPlatformAtomics::InterlockedIncrement(&Frame.FailedHopUps);
+}
+
+uint64 FAdventureMovementTelemetry::GetAllocationCount()
+{
+#if !UE_BUILD_SHIPPING
+	return FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls;
+#else
+	return 0;
+#endif
+}
+
+void FAdventureMovementTelemetry::OnEnabledChanged(IConsoleVariable* Variable)
+{
+	if(bEnabled && !EndFrameHandle.IsValid())
+	{
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FAdventureMovementTelemetry::EndFrame);
+	}
+	else if(!bEnabled && EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+		Frame = FCounters();
+	}
+}
+
+void FAdventureMovementTelemetry::EndFrame()
+{
+#if CSV_PROFILER
+	static TArray<FName> ModeStats;
+	static TArray<FName> QueryStats;
+	static TArray<FName> ClimbingStats;
+	if(ModeStats.Num() == 0)
+	{
+		for(int32 Mode = 0; Mode < NumModes; Mode++)
+		{
+			ModeStats.Add(FName(FString::Printf(TEXT("Mode_%s"), AdventureMovementTelemetry::ModeNames[Mode])));
+			QueryStats.Add(FName(FString::Printf(TEXT("QueriesPerCharacter_%s"), AdventureMovementTelemetry::ModeNames[Mode])));
+		}
+		for(int32 State = 0; State < NumClimbingStates; State++)
+		{
+			ClimbingStats.Add(FName(FString::Printf(TEXT("State_%d"), State)));
+		}
+	}
+
+	const uint32 MovementCategory = CSV_CATEGORY_INDEX(AdventureMovement);
+	for(int32 Mode = 0; Mode < NumModes; Mode++)
+	{
+		FCsvProfiler::RecordCustomStat(ModeStats[Mode], MovementCategory, Frame.Modes[Mode], ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(QueryStats[Mode], MovementCategory,
+			Frame.Modes[Mode] > 0 ? (float)Frame.SceneQueries[Mode] / Frame.Modes[Mode] : 0.f, ECsvCustomStatOp::Set);
+	}
+	CSV_CUSTOM_STAT(AdventureMovement, ModeTransitions, Frame.ModeTransitions, ECsvCustomStatOp::Set);
+
+	const uint32 ClimbingCategory = CSV_CATEGORY_INDEX(AdventureClimbing);
+	for(int32 State = 0; State < NumClimbingStates; State++)
+	{
+		FCsvProfiler::RecordCustomStat(ClimbingStats[State], ClimbingCategory, Frame.ClimbingStates[State], ECsvCustomStatOp::Set);
+	}
+	CSV_CUSTOM_STAT(AdventureClimbing, ClimbingTransitions, Frame.ClimbingTransitions, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(AdventureClimbing, FailedLaunches, Frame.FailedLaunches, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(AdventureClimbing, FailedHopUps, Frame.FailedHopUps, ECsvCustomStatOp::Set);
+#endif
+
+	Totals.Frames++;
+	for(int32 Mode = 0; Mode < NumModes; Mode++)
+	{
+		Totals.Modes[Mode] += Frame.Modes[Mode];
+		Totals.SceneQueries[Mode] += Frame.SceneQueries[Mode];
+	}
+	for(int32 State = 0; State < NumClimbingStates; State++)
+	{
+		Totals.ClimbingStates[State] += Frame.ClimbingStates[State];
+	}
+	Totals.FailedLaunches += Frame.FailedLaunches;
+	Totals.FailedHopUps += Frame.FailedHopUps;
+
+	Frame = FCounters();
+}
+
+void FAdventureMovementTelemetry::Reset()
+{
+	Frame = FCounters();
+	Totals = FTotals();
+}
+
+void FAdventureMovementTelemetry::WriteReport()
+{
+	using namespace AdventureMovementTelemetry;
+
+	// Per frame columns are averages over every recorded frame, counts are totals
+	const double Frames = FMath::Max<int64>(Totals.Frames, 1);
+	FString Csv = TEXT("Kind,From,To,Count,PerFrame,QueriesPerCharacterFrame\n");
+	Csv += FString::Printf(TEXT("Frames,,,%lld,,\n"), Totals.Frames);
+	Csv += FString::Printf(TEXT("FailedLaunch,,,%lld,%.4f,\n"), Totals.FailedLaunches, Totals.FailedLaunches / Frames);
+	Csv += FString::Printf(TEXT("FailedHopUp,,,%lld,%.4f,\n"), Totals.FailedHopUps, Totals.FailedHopUps / Frames);
+
+	for(int32 Mode = 0; Mode < NumModes; Mode++)
+	{
+		if(Totals.Modes[Mode] > 0)
+		{
+			Csv += FString::Printf(TEXT("Mode,%s,,%lld,%.2f,%.2f\n"), ModeNames[Mode], Totals.Modes[Mode],
+				Totals.Modes[Mode] / Frames, (double)Totals.SceneQueries[Mode] / Totals.Modes[Mode]);
+		}
+	}
+
+	for(int32 State = 0; State < NumClimbingStates; State++)
+	{
+		if(Totals.ClimbingStates[State] > 0)
+		{
+			Csv += FString::Printf(TEXT("ClimbingState,%s,,%lld,%.2f,\n"), *GetClimbingStateName(State), Totals.ClimbingStates[State],
+				Totals.ClimbingStates[State] / Frames);
+		}
+	}
+
+	for(int32 From = 0; From < NumModes; From++)
+	{
+		for(int32 To = 0; To < NumModes; To++)
+		{
+			if(Totals.ModeTransitions[From][To] > 0)
+			{
+				Csv += FString::Printf(TEXT("ModeTransition,%s,%s,%d,,\n"), ModeNames[From], ModeNames[To], Totals.ModeTransitions[From][To]);
+			}
+		}
+	}
+
+	for(int32 From = 0; From < NumClimbingStates; From++)
+	{
+		for(int32 To = 0; To < NumClimbingStates; To++)
+		{
+			if(Totals.ClimbingTransitions[From][To] > 0)
+			{
+				Csv += FString::Printf(TEXT("ClimbingTransition,%s,%s,%d,,\n"), *GetClimbingStateName(From), *GetClimbingStateName(To),
+					Totals.ClimbingTransitions[From][To]);
+			}
+		}
+	}
+
+	const FString Path = FPaths::ProfilingDir() / TEXT("MovementTelemetry.csv");
+	FFileHelper::SaveStringToFile(Csv, *Path);
+	UE_LOG(LogAdventureMovement, Log, TEXT("Movement telemetry over %lld frames written to %s\n%s"), Totals.Frames, *Path, *Csv);
+}
@@ -0,0 +1,334 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureNetHarness.h"
+
+#include "AdventureMovementComponent.h"
+#include "ClimbingStressLevelGenerator.h"
+#include "Ledge.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "ShooterAdventure/ShooterAdventureCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace AdventureNetHarness
+{
+	constexpr float StepDuration = 2.f;
+	/** Walking up to the wall, jumping to the ledge and shimmying along it */
+	constexpr float ClimbStepDuration = 8.f;
+
+	/** Course wall in front of the first player start, low enough to grab from a standing jump */
+	const FName CourseName(TEXT("AdventureNetHarnessCourse"));
+	constexpr float CourseDistance = 800.f;
+	constexpr float CourseWallHeight = 200.f;
+	constexpr float CourseWallWidth = 600.f;
+	/** Horizontal distance to the grab point at which the climb step jumps */
+	constexpr float JumpDistance = 150.f;
+
+	const TCHAR* ReportFileName = TEXT("NetCorrections.csv");
+
+	float GetConsoleFloat(const TCHAR* Name)
+	{
+		const IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name);
+		return Variable ? Variable->GetFloat() : 0.f;
+	}
+}
+
+static TAutoConsoleVariable<int32> CVarNetHarnessLoops(
+	TEXT("Adventure.NetHarness.Loops"),
+	0,
+	TEXT("Loops of the scripted movement every local player runs before its corrections are written out, 0 stops the script."));
+
+static TAutoConsoleVariable<FString> CVarNetHarnessTag(
+	TEXT("Adventure.NetHarness.Tag"),
+	TEXT(""),
+	TEXT("Label written with every row of the correction report, used to tell builds apart."));
+
+static FAutoConsoleCommandWithWorld NetHarnessDumpCommand(
+	TEXT("Adventure.NetHarness.Dump"),
+	TEXT("Appends the current client corrections of this world to Saved/Profiling/NetCorrections.csv"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&UAdventureNetHarness::WriteReport));
+
+static FAutoConsoleCommandWithWorld NetHarnessResetCommand(
+	TEXT("Adventure.NetHarness.Reset"),
+	TEXT("Clears the client corrections recorded in this world"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&UAdventureNetHarness::ResetCorrectionStats));
+
+bool UAdventureNetHarness::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return !UE_BUILD_SHIPPING && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UAdventureNetHarness::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAdventureNetHarness::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	AShooterAdventureCharacter* Character = GetLocalCharacter();
+	if(CVarNetHarnessLoops.GetValueOnGameThread() <= 0)
+	{
+		if(bRunning && Character)
+		{
+			ExitStep(Character);
+		}
+		bRunning = false;
+		bFinished = false;
+		DestroyCourse();
+		return;
+	}
+
+	// Built before the local player check, a dedicated server needs the course to accept the clients' climbing
+	if(!bCourseSpawned)
+	{
+		SpawnCourse();
+	}
+
+	if(bFinished || Character == nullptr)
+	{
+		return;
+	}
+
+	if(!bRunning)
+	{
+		ResetCorrectionStats(GetWorld());
+		bRunning = true;
+		LoopsDone = 0;
+		StepIndex = 0;
+		StepTime = 0.f;
+		EnterStep(Character);
+	}
+
+	StepTime += DeltaTime;
+	if(StepTime >= GetStepDuration())
+	{
+		ExitStep(Character);
+		StepTime = 0.f;
+		StepIndex = (StepIndex + 1) % (int32)EStep::Num;
+		if(StepIndex == 0 && ++LoopsDone >= CVarNetHarnessLoops.GetValueOnGameThread())
+		{
+			FinishScript(Character);
+			return;
+		}
+		EnterStep(Character);
+	}
+
+	if(GetStep() == EStep::Climb)
+	{
+		TickClimbStep(Character);
+		return;
+	}
+
+	// Turn a quarter every step so the script stays inside a small area
+	Character->AddMovementInput(FRotator(0.f, 90.f * StepIndex, 0.f).Vector());
+}
+
+TStatId UAdventureNetHarness::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAdventureNetHarness, STATGROUP_Tickables);
+}
+
+AShooterAdventureCharacter* UAdventureNetHarness::GetLocalCharacter() const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController && PlayerController->IsLocalController() ? Cast<AShooterAdventureCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+float UAdventureNetHarness::GetStepDuration() const
+{
+	return GetStep() == EStep::Climb ? AdventureNetHarness::ClimbStepDuration : AdventureNetHarness::StepDuration;
+}
+
+void UAdventureNetHarness::SpawnCourse()
+{
+	bCourseSpawned = true;
+
+	UWorld* World = GetWorld();
+	TActorIterator<APlayerStart> PlayerStart(World);
+	if(!PlayerStart)
+	{
+		UE_LOG(LogAdventureMovement, Warning, TEXT("Net harness: no player start in %s, the climb step has no ledge"), *World->GetName());
+		return;
+	}
+
+	// Placed from the map alone and spawned under a fixed name, so the server and every client build the same ledge id
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = AdventureNetHarness::CourseName;
+	SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+	Course = World->SpawnActor<AClimbingStressLevelGenerator>(AClimbingStressLevelGenerator::StaticClass(), FTransform::Identity, SpawnParams);
+	if(!Course.IsValid())
+	{
+		return;
+	}
+
+	// The wall's grab points face back toward the player start
+	const FVector Floor = PlayerStart->GetActorLocation() - FVector(0.f, 0.f, PlayerStart->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+	const FVector Forward = PlayerStart->GetActorForwardVector().GetSafeNormal2D();
+	const FTransform WallTransform((-Forward).Rotation(), Floor + Forward * AdventureNetHarness::CourseDistance);
+	Course->AddWall(WallTransform, AdventureNetHarness::CourseWallHeight, AdventureNetHarness::CourseWallWidth);
+}
+
+void UAdventureNetHarness::DestroyCourse()
+{
+	if(Course.IsValid())
+	{
+		Course->Destroy();
+	}
+	Course.Reset();
+	bCourseSpawned = false;
+}
+
+const ALedge* UAdventureNetHarness::FindCourseLedge() const
+{
+	for (TActorIterator<ALedge> It(GetWorld()); It; ++It)
+	{
+		if(Course.IsValid() && It->GetOwner() == Course.Get())
+		{
+			return *It;
+		}
+	}
+
+	return nullptr;
+}
+
+void UAdventureNetHarness::TickClimbStep(AShooterAdventureCharacter* Character)
+{
+	const UAdventureMovementComponent* Movement = Character->GetAdventureMovementComponent();
+	if(Movement->IsCustomMovementMode(CMOVE_Climbing))
+	{
+		// Shimmy back and forth along the ledge, a second each way
+		const float Direction = FMath::Fmod(StepTime, 2.f) < 1.f ? 1.f : -1.f;
+		Character->AddMovementInput(Character->GetActorRightVector() * Direction);
+		return;
+	}
+
+	const ALedge* Ledge = FindCourseLedge();
+	FLedgeGrabPoint GrabPoint;
+	if(Ledge == nullptr || !Ledge->GetClosestGrabPoint(Character->GetActorLocation(), GrabPoint))
+	{
+		return;
+	}
+
+	// Walk up to the wall and jump, the climbing probe grabs the ledge on the way up
+	const FVector ToGrabPoint = GrabPoint.Location - Character->GetActorLocation();
+	Character->AddMovementInput(ToGrabPoint.GetSafeNormal2D());
+	if(Movement->IsMovingOnGround() && ToGrabPoint.Size2D() < AdventureNetHarness::JumpDistance)
+	{
+		Character->Jump();
+	}
+}
+
+void UAdventureNetHarness::EnterStep(AShooterAdventureCharacter* Character)
+{
+	UAdventureMovementComponent* Movement = Character->GetAdventureMovementComponent();
+	switch (GetStep())
+	{
+	case EStep::Sprint:
+		Movement->Sprint();
+		break;
+	case EStep::Slide:
+		Movement->Sprint();
+		Movement->ToggleCrouch();
+		break;
+	case EStep::Roll:
+		Movement->TryEnterRoll();
+		break;
+	case EStep::Jump:
+		// Ends up climbing when the test map has a ledge in reach
+		Character->Jump();
+		break;
+	default:
+		break;
+	}
+}
+
+void UAdventureNetHarness::ExitStep(AShooterAdventureCharacter* Character)
+{
+	UAdventureMovementComponent* Movement = Character->GetAdventureMovementComponent();
+	if(Movement->IsCustomMovementMode(CMOVE_Climbing))
+	{
+		Character->DropClimb();
+	}
+	Movement->StopSprint();
+	if(Movement->bWantsToCrouch)
+	{
+		Movement->ToggleCrouch();
+	}
+	Character->StopJumping();
+}
+
+void UAdventureNetHarness::FinishScript(AShooterAdventureCharacter* Character)
+{
+	bRunning = false;
+	bFinished = true;
+	WriteReport(GetWorld());
+	UE_LOG(LogAdventureMovement, Log, TEXT("Net harness finished %d loops in %s"), LoopsDone, *GetNameSafe(GetWorld()));
+}
+
+void UAdventureNetHarness::WriteReport(UWorld* World)
+{
+	TMap<FName, FAdventureCorrectionStats> Totals;
+	float MaxSmoothDistance = 0.f;
+	float NoSmoothDistance = 0.f;
+	for (TObjectIterator<UAdventureMovementComponent> It; It; ++It)
+	{
+		if(It->GetWorld() != World)
+		{
+			continue;
+		}
+
+		MaxSmoothDistance = It->NetworkMaxSmoothUpdateDistance;
+		NoSmoothDistance = It->NetworkNoSmoothUpdateDistance;
+		for (const TPair<FName, FAdventureCorrectionStats>& Pair : It->GetCorrectionStats())
+		{
+			FAdventureCorrectionStats& Total = Totals.FindOrAdd(Pair.Key);
+			Total.Corrections += Pair.Value.Corrections;
+			Total.ResimulatedMoves += Pair.Value.ResimulatedMoves;
+			Total.TotalDistance += Pair.Value.TotalDistance;
+			Total.MaxDistance = FMath::Max(Total.MaxDistance, Pair.Value.MaxDistance);
+		}
+	}
+
+	const FString Path = FPaths::ProfilingDir() / AdventureNetHarness::ReportFileName;
+	FString Csv;
+	if(!IFileManager::Get().FileExists(*Path))
+	{
+		Csv += TEXT("Tag,Build,World,NetMode,Mode,Corrections,ResimulatedMoves,AvgDistance,MaxDistance,MaxSmoothDist,NoSmoothDist,PktLag,PktLagVariance,PktLoss\n");
+	}
+
+	const FString NetMode = World->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server");
+	const FString Conditions = FString::Printf(TEXT("%.0f,%.0f,%.0f,%.0f,%.1f"), MaxSmoothDistance, NoSmoothDistance,
+		AdventureNetHarness::GetConsoleFloat(TEXT("NetEmulation.PktLag")),
+		AdventureNetHarness::GetConsoleFloat(TEXT("NetEmulation.PktLagVariance")),
+		AdventureNetHarness::GetConsoleFloat(TEXT("NetEmulation.PktLoss")));
+	for (const TPair<FName, FAdventureCorrectionStats>& Pair : Totals)
+	{
+		const FAdventureCorrectionStats& Stats = Pair.Value;
+		Csv += FString::Printf(TEXT("%s,%s,%s,%s,%s,%d,%d,%.2f,%.2f,%s\n"), *CVarNetHarnessTag.GetValueOnGameThread(), FApp::GetBuildVersion(),
+			*World->GetName(), *NetMode, *Pair.Key.ToString(), Stats.Corrections, Stats.ResimulatedMoves,
+			Stats.Corrections > 0 ? Stats.TotalDistance / Stats.Corrections : 0.f, Stats.MaxDistance, *Conditions);
+	}
+
+	FFileHelper::SaveStringToFile(Csv, *Path, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	UE_LOG(LogAdventureMovement, Log, TEXT("Wrote %d correction rows for %s to %s"), Totals.Num(), *World->GetName(), *Path);
+}
+
+void UAdventureNetHarness::ResetCorrectionStats(UWorld* World)
+{
+	for (TObjectIterator<UAdventureMovementComponent> It; It; ++It)
+	{
+		if(It->GetWorld() == World)
+		{
+			It->ResetCorrectionStats();
+		}
+	}
+}
@@ -0,0 +1,343 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AdventureReplicationGraph.h"
+
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "ShooterAdventureCharacter.h"
+#include "Engine/ChildConnection.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+
+namespace AdventureReplicationGraph
+{
+	/** Weight of the newest sample in the smoothed replication time */
+	constexpr double ReplicateTimeSmoothing = 0.05;
+}
+
+static FAutoConsoleCommandWithWorld ReplicationReportCommand(
+	TEXT("Adventure.Net.ReportReplication"),
+	TEXT("Logs server replication time and outgoing bytes per client connection"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if(NetDriver == nullptr || !NetDriver->IsServer())
+		{
+			UE_LOG(LogAdventureMovement, Warning, TEXT("Adventure.Net.ReportReplication only runs on a server"));
+			return;
+		}
+
+		int64 TotalBytesPerSecond = 0;
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			TotalBytesPerSecond += Connection->OutBytesPerSecond;
+		}
+
+		const int32 NumConnections = NetDriver->ClientConnections.Num();
+		const UAdventureReplicationGraph* Graph = NetDriver->GetReplicationDriver<UAdventureReplicationGraph>();
+		UE_LOG(LogAdventureMovement, Log, TEXT("Connections: %d, replicate: %.3f ms, out: %.1f KB/s total, %.0f bytes/s per connection"),
+			NumConnections, Graph ? Graph->GetAverageReplicateMs() : 0.0, TotalBytesPerSecond / 1024.f,
+			NumConnections > 0 ? (float)TotalBytesPerSecond / NumConnections : 0.f);
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// UAdventureReplicationGraphNode_ClimbingFrequency
+
+UAdventureReplicationGraphNode_ClimbingFrequency::UAdventureReplicationGraphNode_ClimbingFrequency()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UAdventureReplicationGraphNode_ClimbingFrequency::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if(AShooterAdventureCharacter* Character = Cast<AShooterAdventureCharacter>(ActorInfo.Actor))
+	{
+		Characters.Add(Character);
+	}
+}
+
+bool UAdventureReplicationGraphNode_ClimbingFrequency::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	AShooterAdventureCharacter* Character = Cast<AShooterAdventureCharacter>(ActorInfo.Actor);
+	ClimbingCharacters.RemoveSingleSwap(Character, false);
+	StoppedClimbingCharacters.RemoveSingleSwap(Character, false);
+	const bool bRemoved = Characters.RemoveSingleSwap(Character, false) > 0;
+	if(!bRemoved && bWarnIfNotFound)
+	{
+		UE_LOG(LogAdventureMovement, Warning, TEXT("Climbing frequency node could not remove %s"), *GetNameSafe(ActorInfo.Actor));
+	}
+
+	return bRemoved;
+}
+
+void UAdventureReplicationGraphNode_ClimbingFrequency::NotifyResetAllNetworkActors()
+{
+	Characters.Reset();
+	ClimbingCharacters.Reset();
+	StoppedClimbingCharacters.Reset();
+}
+
+void UAdventureReplicationGraphNode_ClimbingFrequency::PrepareForReplication()
+{
+	StoppedClimbingCharacters.Reset();
+	for (AShooterAdventureCharacter* Character : ClimbingCharacters)
+	{
+		if(Character->IsClimbingState(CLIMB_NONE))
+		{
+			StoppedClimbingCharacters.Add(Character);
+		}
+	}
+
+	ClimbingCharacters.Reset();
+	for (AShooterAdventureCharacter* Character : Characters)
+	{
+		if(!Character->IsClimbingState(CLIMB_NONE))
+		{
+			ClimbingCharacters.Add(Character);
+		}
+	}
+}
+
+void UAdventureReplicationGraphNode_ClimbingFrequency::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Actors are gathered by the grid, this only adjusts how often the connection gets them.
+	// Characters the connection never replicated have no info yet and keep their class period until they do
+	for (AShooterAdventureCharacter* Character : ClimbingCharacters)
+	{
+		if(FConnectionReplicationActorInfo* ConnectionInfo = Params.ConnectionManager.ActorInfoMap.Find(Character))
+		{
+			const FGlobalActorReplicationInfo& GlobalInfo = GraphGlobals->GlobalActorReplicationInfoMap->Get(Character);
+			ConnectionInfo->ReplicationPeriodFrame = FMath::Max(GlobalInfo.Settings.ReplicationPeriodFrame, GetClimbingPeriodFrame(Character, Params.Viewers));
+		}
+	}
+
+	for (AShooterAdventureCharacter* Character : StoppedClimbingCharacters)
+	{
+		if(FConnectionReplicationActorInfo* ConnectionInfo = Params.ConnectionManager.ActorInfoMap.Find(Character))
+		{
+			ConnectionInfo->ReplicationPeriodFrame = GraphGlobals->GlobalActorReplicationInfoMap->Get(Character).Settings.ReplicationPeriodFrame;
+		}
+	}
+}
+
+uint32 UAdventureReplicationGraphNode_ClimbingFrequency::GetClimbingPeriodFrame(const AShooterAdventureCharacter* Character, const FNetViewerArray& Viewers) const
+{
+	if(Buckets.Num() == 0)
+	{
+		return 1;
+	}
+
+	const FVector Location = Character->GetActorLocation();
+	float MinDistanceSquared = MAX_flt;
+	for (const FNetViewer& Viewer : Viewers)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, (float)FVector::DistSquared(Viewer.ViewLocation, Location));
+	}
+
+	for (const FAdventureRepFrequencyBucket& Bucket : Buckets)
+	{
+		if(MinDistanceSquared <= FMath::Square(Bucket.MaxDistance))
+		{
+			return FMath::Max(Bucket.ReplicationPeriodFrame, 1);
+		}
+	}
+
+	return FMath::Max(Buckets.Last().ReplicationPeriodFrame, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UAdventureReplicationGraph
+
+UAdventureReplicationGraph::UAdventureReplicationGraph()
+{
+	ClimbingFrequencyBuckets =
+	{
+		{ 2000.f, 1 },
+		{ 5000.f, 2 },
+		{ 10000.f, 4 },
+	};
+}
+
+void UAdventureReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	ClassRepPolicies.Set(AReplicationGraphDebugActor::StaticClass(), EAdventureClassRepPolicy::NotRouted);
+	ClassRepPolicies.Set(ALevelScriptActor::StaticClass(), EAdventureClassRepPolicy::NotRouted);
+	// Gathered by the connection's always relevant node as its viewer
+	ClassRepPolicies.Set(APlayerController::StaticClass(), EAdventureClassRepPolicy::NotRouted);
+	// Game state, player states and world settings
+	ClassRepPolicies.Set(AInfo::StaticClass(), EAdventureClassRepPolicy::RelevantAllConnections);
+	ClassRepPolicies.Set(AShooterAdventureCharacter::StaticClass(), EAdventureClassRepPolicy::Spatialize_Dynamic);
+
+	// Fallback for classes loaded or made replicated after this runs
+	FClassReplicationInfo ActorInfo;
+	ActorInfo.SetCullDistanceSquared(GetDefault<AActor>()->NetCullDistanceSquared);
+	ActorInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<AActor>()->NetUpdateFrequency);
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), ActorInfo);
+
+	// Every replicated class starts from the settings of its class default object
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if(ActorCDO == nullptr || !ActorCDO->GetIsReplicated()
+			|| Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UAdventureReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = SpatialCellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	ClimbingFrequencyNode = CreateNewNode<UAdventureReplicationGraphNode_ClimbingFrequency>();
+	ClimbingFrequencyNode->Buckets = ClimbingFrequencyBuckets;
+	ClimbingFrequencyNode->Buckets.Sort([](const FAdventureRepFrequencyBucket& A, const FAdventureRepFrequencyBucket& B)
+	{
+		return A.MaxDistance < B.MaxDistance;
+	});
+	AddGlobalGraphNode(ClimbingFrequencyNode);
+}
+
+void UAdventureReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// Keeps the connection's controller, pawn and view target relevant wherever they are on the grid
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* ConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(ConnectionNode, ConnectionManager);
+
+	UReplicationGraphNode_ActorList* OwnerNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddConnectionGraphNode(OwnerNode, ConnectionManager);
+	OwnerConnectionNodes.Add(ConnectionManager->NetConnection, OwnerNode);
+}
+
+void UAdventureReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	Super::RemoveClientConnection(NetConnection);
+	OwnerConnectionNodes.Remove(NetConnection);
+}
+
+bool UAdventureReplicationGraph::AddToOwnerConnectionNode(const FNewReplicatedActorInfo& ActorInfo)
+{
+	UNetConnection* Connection = ActorInfo.Actor->GetNetConnection();
+	if(const UChildConnection* ChildConnection = Cast<UChildConnection>(Connection))
+	{
+		Connection = ChildConnection->Parent;
+	}
+
+	UReplicationGraphNode_ActorList** OwnerNode = Connection ? OwnerConnectionNodes.Find(Connection) : nullptr;
+	if(OwnerNode == nullptr)
+	{
+		return false;
+	}
+
+	(*OwnerNode)->NotifyAddNetworkActor(ActorInfo);
+	return true;
+}
+
+EAdventureClassRepPolicy UAdventureReplicationGraph::GetClassRepPolicy(UClass* Class)
+{
+	if(const EAdventureClassRepPolicy* Policy = ClassRepPolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	const AActor* ActorCDO = GetDefault<AActor>(Class);
+	const EAdventureClassRepPolicy Policy = ActorCDO->bOnlyRelevantToOwner ? EAdventureClassRepPolicy::RelevantOwnerConnection
+		: ActorCDO->bAlwaysRelevant ? EAdventureClassRepPolicy::RelevantAllConnections : EAdventureClassRepPolicy::Spatialize_Dynamic;
+	ClassRepPolicies.Set(Class, Policy);
+
+	return Policy;
+}
+
+void UAdventureReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetClassRepPolicy(ActorInfo.Class))
+	{
+	case EAdventureClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EAdventureClassRepPolicy::RelevantOwnerConnection:
+		// Owners are often set right after spawning, picked up again before the next replication
+		if(!AddToOwnerConnectionNode(ActorInfo))
+		{
+			PendingOwnerConnectionActors.Add(ActorInfo);
+		}
+		break;
+	case EAdventureClassRepPolicy::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+
+	if(ActorInfo.Actor->IsA<AShooterAdventureCharacter>())
+	{
+		ClimbingFrequencyNode->NotifyAddNetworkActor(ActorInfo);
+	}
+}
+
+void UAdventureReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetClassRepPolicy(ActorInfo.Class))
+	{
+	case EAdventureClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EAdventureClassRepPolicy::RelevantOwnerConnection:
+		if(PendingOwnerConnectionActors.RemoveAllSwap([&ActorInfo](const FNewReplicatedActorInfo& Pending) { return Pending.Actor == ActorInfo.Actor; }) == 0)
+		{
+			// The owning connection may be gone or have changed since the actor was routed
+			for (const TPair<UNetConnection*, UReplicationGraphNode_ActorList*>& OwnerNode : OwnerConnectionNodes)
+			{
+				OwnerNode.Value->NotifyRemoveNetworkActor(ActorInfo, false);
+			}
+		}
+		break;
+	case EAdventureClassRepPolicy::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	default:
+		break;
+	}
+
+	if(ActorInfo.Actor->IsA<AShooterAdventureCharacter>())
+	{
+		ClimbingFrequencyNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+}
+
+int32 UAdventureReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	PendingOwnerConnectionActors.RemoveAllSwap([this](const FNewReplicatedActorInfo& ActorInfo)
+	{
+		return AddToOwnerConnectionNode(ActorInfo);
+	});
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	AverageReplicateMs = FMath::Lerp(AverageReplicateMs, ElapsedMs, AdventureReplicationGraph::ReplicateTimeSmoothing);
+	return Result;
+}
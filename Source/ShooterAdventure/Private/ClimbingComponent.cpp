@@ -4,9 +4,15 @@
 #include "ClimbingComponent.h"
 
 #include "Ledge.h"
+#include "SplineLedge.h"
+#include "LedgeRegistry.h"
+#include "ClimbingProbeBatch.h"
+#include "AdventureMovementTelemetry.h"
+#include "AdventureConfigMigration.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "ShooterAdventure/ShooterAdventureCharacter.h"
 #include "Components/CapsuleComponent.h"
 #include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetSystemLibrary.h"
 
 // Helper Macros
 #if 1
@@ -22,14 +28,31 @@ float MacroDuration = 4.f;
 #define CAPSULE(x, c)
 #endif
 
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<bool> CVarClimbingCheckAllocations(
+	TEXT("Adventure.Climbing.CheckAllocations"),
+	false,
+	TEXT("Counts allocator calls around the climbing update while hanging and shimmying and logs every frame that had any. ")
+	TEXT("Other threads count too, with -onethread the count is exact and any allocation fails an ensure."));
+#endif
+
+namespace ClimbingQueries
+{
+	constexpr int32 ReservedHits = 32;
+	constexpr int32 ReservedOverlaps = 64;
+}
+
 // Sets default values for this component's properties
 UClimbingComponent::UClimbingComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = false;
+	// Ticking is switched on by the owning character only while there is climbing work to do
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	ClimbProxyObjectTypes.Add(UEngineTypes::ConvertToObjectType(ALedge::ClimbProxyChannel));
 
-	// ...
+	// Resolved again on register, until then the class defaults stand in
+	Config = GetDefault<UClimbingConfig>();
 }
 
 
@@ -38,21 +61,286 @@ void UClimbingComponent::BeginPlay()
 {
 	Super::BeginPlay();
 	CapsuleComponent = GetOwner()->FindComponentByClass<UCapsuleComponent>();
+	ClimbProxyObjectParams = FCollisionObjectQueryParams(ClimbProxyObjectTypes);
+	BuildQueryContext();
+
+	if(bBatchProbes)
+	{
+		if(UClimbingProbeBatch* Batch = GetProbeBatch())
+		{
+			Batch->Register(this);
+		}
+	}
+}
+
+void UClimbingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(UClimbingProbeBatch* Batch = GetProbeBatch())
+	{
+		Batch->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UClimbingComponent::BuildQueryContext()
+{
+	using namespace ClimbingQueries;
+
+	TArray<AActor*> Children;
+	GetOwner()->GetAllChildActors(Children);
+
+	QueryContext.Params = FCollisionQueryParams(SCENE_QUERY_STAT(ClimbQuery), false, GetOwner());
+	QueryContext.Params.AddIgnoredActors(Children);
+	QueryContext.ComponentParams = FCollisionQueryParams(SCENE_QUERY_STAT(ClimbTop), false);
+	QueryContext.CapsuleParams = QueryContext.Params;
+	if(CapsuleComponent != nullptr)
+	{
+		CapsuleComponent->InitSweepCollisionParams(QueryContext.CapsuleParams, QueryContext.CapsuleResponseParams);
+	}
+
+	QueryContext.SweepHits.Reserve(ReservedHits);
+	QueryContext.LineHits.Reserve(ReservedHits);
+	QueryContext.Overlaps.Reserve(ReservedOverlaps);
+}
+
+SIZE_T UClimbingComponent::FClimbingQueryContext::GetAllocatedSize() const
+{
+	return SweepHits.GetAllocatedSize() + LineHits.GetAllocatedSize() + Overlaps.GetAllocatedSize();
+}
+
+const FCollisionQueryParams& UClimbingComponent::GetQueryParams(const TStatId& StatId) const
+{
+	RecordSceneQuery();
+	QueryContext.Params.StatId = StatId;
+	return QueryContext.Params;
+}
+
+bool UClimbingComponent::IsCapsuleBlockedAt(const FVector& Location, const FQuat& Rotation, const TStatId& StatId) const
+{
+	// Same test the movement component uses for encroachment: only what would block the capsule, early out on the first blocker
+	RecordSceneQuery();
+	QueryContext.CapsuleParams.StatId = StatId;
+	return GetWorld()->OverlapBlockingTestByChannel(Location, Rotation, CapsuleComponent->GetCollisionObjectType(),
+		CapsuleComponent->GetCollisionShape(), QueryContext.CapsuleParams, QueryContext.CapsuleResponseParams);
+}
+
+void UClimbingComponent::RecordSceneQuery() const
+{
+	if(!FAdventureMovementTelemetry::IsEnabled())
+	{
+		return;
+	}
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	if(const UCharacterMovementComponent* Movement = Character ? Character->GetCharacterMovement() : nullptr)
+	{
+		FAdventureMovementTelemetry::RecordSceneQuery(Movement->MovementMode, Movement->CustomMovementMode);
+	}
+}
+
+void UClimbingComponent::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Tuning saved on the component before UClimbingConfig existed
+	if(ClimbingConfig == nullptr)
+	{
+		ClimbingConfig = MigrateDeprecatedConfig<UClimbingConfig>(this);
+		if(ClimbingConfig != nullptr)
+		{
+			UE_LOG(LogAdventureMovement, Warning, TEXT("%s: moved deprecated tuning into %s, resave the asset or point it at a shared config"), *GetPathName(), *ClimbingConfig->GetName());
+		}
+	}
+#endif
+}
+
+void UClimbingComponent::OnRegister()
+{
+	Super::OnRegister();
+	Config = ClimbingConfig != nullptr ? ClimbingConfig.Get() : GetDefault<UClimbingConfig>();
+}
+
+void UClimbingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if(AShooterAdventureCharacter* Character = Cast<AShooterAdventureCharacter>(GetOwner()))
+	{
+#if !UE_BUILD_SHIPPING
+		const SIZE_T QueryBufferSize = QueryContext.GetAllocatedSize();
+		const bool bCheckAllocations = CVarClimbingCheckAllocations.GetValueOnGameThread() && Character->IsClimbingState(CLIMB_HANGING);
+		const uint64 StartAllocations = bCheckAllocations ? FAdventureMovementTelemetry::GetAllocationCount() : 0;
+#endif
+		Character->ClimbingUpdate(DeltaTime);
+		// The probe was taken before this tick moved anything, don't let later calls this frame read it
+		BatchedProbe.Frame = MAX_uint64;
+#if !UE_BUILD_SHIPPING
+		// Leaving the hang starts montages and timers, only a frame that stayed hanging has to be free of allocations
+		if(bCheckAllocations && Character->IsClimbingState(CLIMB_HANGING))
+		{
+			const uint64 Allocations = FAdventureMovementTelemetry::GetAllocationCount() - StartAllocations;
+			if(Allocations > 0)
+			{
+				UE_LOG(LogAdventureMovement, Warning, TEXT("%s: %llu allocations in the hanging climbing update"), *GetOwner()->GetName(), Allocations);
+			}
+			ensureMsgf(Allocations == 0 || FPlatformProcess::SupportsMultithreading(), TEXT("Hanging climbing update allocated %llu times"), Allocations);
+		}
+		if(QueryContext.GetAllocatedSize() != QueryBufferSize)
+		{
+			UE_LOG(LogAdventureMovement, Warning, TEXT("%s: climbing query buffers grew to %llu bytes, raise the reserved sizes"), *GetOwner()->GetName(), (uint64)QueryContext.GetAllocatedSize());
+		}
+#endif
+	}
+}
+
+bool UClimbingComponent::IsNearClimbableGeometry(const FVector& Velocity) const
+{
+	return HasBatchedProbe() ? BatchedProbe.bNearLedge : QueryNearClimbableGeometry(Velocity);
+}
+
+bool UClimbingComponent::QueryNearClimbableGeometry(const FVector& Velocity) const
+{
+	const float Radius = Config->MaxTraceDistance + Config->CapsuleTraceHeight + Velocity.Size() * Config->IdleFallingTickInterval;
+	const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbProximity));
+	if(bUseLedgeProxies)
+	{
+		return GetWorld()->OverlapAnyTestByObjectType(GetTraceOrigin(), FQuat::Identity, ClimbProxyObjectParams, FCollisionShape::MakeSphere(Radius), Params);
+	}
+
+	return GetWorld()->OverlapAnyTestByChannel(GetTraceOrigin(), FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel),
+		FCollisionShape::MakeSphere(Radius), Params);
 }
 
 FVector UClimbingComponent::GetTraceOrigin() const
 {
-	return GetOwner()->GetActorLocation() + TraceOrigin;
+	return GetOwner()->GetActorLocation() + Config->TraceOrigin;
 }
 
-bool UClimbingComponent::IsPossibleToReach(const USceneComponent* Candidate, FVector& TossVelocity, float Gravity) const
+bool UClimbingComponent::SweepClimbable(FHitResult& Hit, const FVector& Start, const FVector& End, const FCollisionShape& Shape) const
 {
-	FHitResult HitResult;
-	HitResult.ImpactPoint = Candidate->GetComponentLocation();
-	HitResult.Normal = Candidate->GetForwardVector();
-	HitResult.ImpactNormal = Candidate->GetForwardVector();
-	const FVector EndLocation = GetCharacterLocationOnLedge(HitResult, HitResult);
-	if(FoundSuggestVelocity(TossVelocity, GetOwner()->GetActorLocation(), EndLocation, MaxJumpSpeed, Gravity))
+	const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbSweep));
+	const bool bHit = bUseLedgeProxies
+		? GetWorld()->SweepSingleByObjectType(Hit, Start, End, FQuat::Identity, ClimbProxyObjectParams, Shape, Params)
+		: GetWorld()->SweepSingleByChannel(Hit, Start, End, FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel), Shape, Params);
+
+	if(DebugTrace)
+	{
+		LINE(Start, bHit ? Hit.Location : End, bHit ? FColor::Green : FColor::Red);
+	}
+
+	return bHit;
+}
+
+bool UClimbingComponent::SweepClimbableMulti(const FVector& Start, const FVector& End, const FCollisionShape& Shape) const
+{
+	TArray<FHitResult>& Hits = QueryContext.SweepHits;
+	Hits.Reset();
+	const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbSweepMulti));
+	const bool bHit = bUseLedgeProxies
+		? GetWorld()->SweepMultiByObjectType(Hits, Start, End, FQuat::Identity, ClimbProxyObjectParams, Shape, Params)
+		: GetWorld()->SweepMultiByChannel(Hits, Start, End, FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel), Shape, Params);
+
+	if(DebugTrace)
+	{
+		LINE(Start, End, bHit ? FColor::Green : FColor::Blue);
+	}
+
+	return bHit;
+}
+
+bool UClimbingComponent::OverlapClimbable(const FVector& Location, const FCollisionShape& Shape) const
+{
+	TArray<FOverlapResult>& Overlaps = QueryContext.Overlaps;
+	Overlaps.Reset();
+	const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbOverlap));
+	if(bUseLedgeProxies)
+	{
+		return GetWorld()->OverlapMultiByObjectType(Overlaps, Location, FQuat::Identity, ClimbProxyObjectParams, Shape, Params);
+	}
+
+	return GetWorld()->OverlapMultiByChannel(Overlaps, Location, FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel), Shape, Params);
+}
+
+bool UClimbingComponent::SweepLedge(const AActor* Ledge, FHitResult& Hit, const FVector& Start, const FVector& End, const FCollisionShape& Shape) const
+{
+	if(Ledge == nullptr)
+	{
+		return false;
+	}
+
+	if(!bUseLedgeProxies)
+	{
+		SweepClimbableMulti(Start, End, Shape);
+		for (const FHitResult& Candidate : QueryContext.SweepHits)
+		{
+			if(Candidate.GetActor() == Ledge)
+			{
+				Hit = Candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Only the ledge's own proxies are tested, there is no scene query at all
+	bool bHit = false;
+	Ledge->ForEachComponent<UPrimitiveComponent>(false, [&](UPrimitiveComponent* Component)
+	{
+		FHitResult ComponentHit;
+		if((ClimbProxyObjectParams.GetObjectTypesToQuery() & ECC_TO_BITFIELD(Component->GetCollisionObjectType()))
+			&& Component->SweepComponent(ComponentHit, Start, End, FQuat::Identity, Shape, false)
+			&& (!bHit || ComponentHit.Time < Hit.Time))
+		{
+			Hit = ComponentHit;
+			bHit = true;
+		}
+	});
+
+	if(DebugTrace)
+	{
+		LINE(Start, bHit ? Hit.Location : End, bHit ? FColor::Green : FColor::Blue);
+	}
+
+	return bHit;
+}
+
+bool UClimbingComponent::TraceLedgeTop(const FHitResult& ForwardHit, const FVector& Start, const FVector& End, FHitResult& TopHit) const
+{
+	if(DebugTrace)
+	{
+		LINE(Start, End, FColor::Yellow);
+	}
+
+	if(bUseLedgeProxies)
+	{
+		// The forward hit already found the proxy, trace that primitive alone
+		UPrimitiveComponent* Component = ForwardHit.GetComponent();
+		return Component != nullptr && Component->LineTraceComponent(TopHit, Start, End, QueryContext.ComponentParams);
+	}
+
+	TArray<FHitResult>& Hits = QueryContext.LineHits;
+	Hits.Reset();
+	if(GetWorld()->LineTraceMultiByChannel(Hits, Start, End, UEngineTypes::ConvertToCollisionChannel(TraceChannel), GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbTop))))
+	{
+		for (const FHitResult& Hit : Hits)
+		{
+			if(Hit.bBlockingHit && Hit.GetActor() == ForwardHit.GetActor())
+			{
+				TopHit = Hit;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool UClimbingComponent::IsPossibleToReach(const FLedgeGrabPoint& Candidate, FVector& TossVelocity, float Gravity) const
+{
+	const FVector EndLocation = GetCharacterLocationOnEdge(Candidate);
+	if(FoundSuggestVelocity(TossVelocity, GetOwner()->GetActorLocation(), EndLocation, Config->MaxJumpSpeed, Gravity))
 	{
 		return true;
 	}
@@ -60,133 +348,157 @@ bool UClimbingComponent::IsPossibleToReach(const USceneComponent* Candidate, FVe
 	return false;
 }
 
-bool UClimbingComponent::FoundSuggestVelocity(FVector& TossVelocity, FVector StartLocation, FVector EndLocation, float MaxSpeed, float Gravity) const
+bool UClimbingComponent::FoundSuggestVelocity(FVector& TossVelocity, const FVector& StartLocation, const FVector& EndLocation, float MaxSpeed, float Gravity) const
 {
 	if(DebugTrace)
 	{
 		CAPSULE(EndLocation, FColor::Blue);
 	}
 	
+	static const TArray<AActor*> NoIgnoredActors;
 	const bool bHighArc = EndLocation.Z < GetOwner()->GetActorLocation().Z; 
 	return UGameplayStatics::SuggestProjectileVelocity(GetWorld(), TossVelocity, StartLocation,
 		EndLocation, MaxSpeed, bHighArc, 0, Gravity, ESuggestProjVelocityTraceOption::DoNotTrace,
-		FCollisionResponseParams::DefaultResponseParam, TArray<AActor*>(), DebugTrace);
+		FCollisionResponseParams::DefaultResponseParam, NoIgnoredActors, DebugTrace);
 }
 
-FHitResult UClimbingComponent::GetForwardHit(FVector TraceStartOrigin, FVector TraceDirection, float TraceHeight) const
+bool UClimbingComponent::GetForwardHit(FHitResult& FwdHit, const FVector& TraceStartOrigin, const FVector& TraceDirection, float TraceHeight) const
 {
-	FHitResult Hit;
-
-	const FVector StartTrace = TraceStartOrigin;
-	const FVector EndTrace = StartTrace + TraceDirection * MaxTraceDistance;
-	UKismetSystemLibrary::CapsuleTraceSingle(GetWorld(), StartTrace, EndTrace, CapsuleTraceRadius, TraceHeight, TraceChannel, false,
-		TArray<AActor*>(), DebugTrace ? EDrawDebugTrace::ForDuration : EDrawDebugTrace::None, Hit, true);
-
-	return Hit;
+	const FVector EndTrace = TraceStartOrigin + TraceDirection * Config->MaxTraceDistance;
+	return SweepClimbable(FwdHit, TraceStartOrigin, EndTrace, FCollisionShape::MakeCapsule(Config->CapsuleTraceRadius, TraceHeight)) && FwdHit.IsValidBlockingHit();
 }
 
-FHitResult UClimbingComponent::GetTopHit(FHitResult forwardHit, FVector TraceDirection, FVector TraceStartOrigin) const
+bool UClimbingComponent::GetTopHit(FHitResult& TopHit, const FHitResult& FwdHit, const FVector& TraceDirection, const FVector& TraceStartOrigin) const
 {
-	FHitResult TopHit;
-	FCollisionQueryParams Params;
-
-	const FVector StartTrace = TraceStartOrigin + FVector::UpVector * MaxTraceHeight;
-	const float step = MaxTopTraceDepth / TopTraceIterations;
+	const FVector StartTrace = TraceStartOrigin + FVector::UpVector * Config->MaxTraceHeight;
+	const float step = Config->MaxTopTraceDepth / Config->TopTraceIterations;
 	
-	for (int i=0; i< TopTraceIterations; i++)
+	for (int i=0; i< Config->TopTraceIterations; i++)
 	{
-		FVector TraceStartIteration = StartTrace + TraceDirection * (i * step);
-		FVector EndTrace = TraceStartIteration + FVector::DownVector * MaxTraceHeight * 2.f;
-		TArray<FHitResult> Hits;		
-		if(UKismetSystemLibrary::LineTraceMulti(GetWorld(), TraceStartIteration, EndTrace, TraceChannel, true,
-			TArray<AActor*>(), DebugTrace ? EDrawDebugTrace::ForDuration : EDrawDebugTrace::None, Hits, true, FLinearColor::Yellow))
+		const FVector TraceStartIteration = StartTrace + TraceDirection * (i * step);
+		const FVector EndTrace = TraceStartIteration + FVector::DownVector * Config->MaxTraceHeight * 2.f;
+		if(TraceLedgeTop(FwdHit, TraceStartIteration, EndTrace, TopHit))
 		{
-			for (auto Hit : Hits)
-			{
-				if(Hit.bBlockingHit && Hit.GetActor() == forwardHit.GetActor())
-				{
-					return Hit;
-				}
-			}
+			return TopHit.IsValidBlockingHit();
 		}
 	}
 	
-	return TopHit;
+	return false;
 }
 
 bool UClimbingComponent::FoundLedge(FHitResult& FwdHit, FHitResult& TopHit) const
 {	
-	FwdHit = GetForwardHit(GetTraceOrigin(), GetOwner()->GetActorForwardVector(), CapsuleTraceHeight);
-	if(!FwdHit.IsValidBlockingHit())
+	const FVector Origin = GetTraceOrigin();
+	const FVector Forward = GetOwner()->GetActorForwardVector();
+	return GetForwardHit(FwdHit, Origin, Forward, Config->CapsuleTraceHeight) && GetTopHit(TopHit, FwdHit, Forward, Origin);
+}
+
+bool UClimbingComponent::FoundFallingLedge(FHitResult& FwdHit, FHitResult& TopHit) const
+{
+	if(!HasBatchedProbe() || !BatchedProbe.bSearchLedge)
+	{
+		return FoundLedge(FwdHit, TopHit);
+	}
+
+	FwdHit = BatchedProbe.FwdHit;
+	TopHit = BatchedProbe.TopHit;
+	return BatchedProbe.bFoundLedge;
+}
+
+bool UClimbingComponent::PrepareBatchedProbe()
+{
+	BatchedProbe.Frame = MAX_uint64;
+
+	// Debug drawing is game thread only, and components on the idle interval probe inline when they wake up
+	const AShooterAdventureCharacter* Character = Cast<AShooterAdventureCharacter>(GetOwner());
+	if(!bBatchProbes || DebugTrace || Character == nullptr || !IsComponentTickEnabled() || GetComponentTickInterval() > 0.f
+		|| Character->GetClimbingState() != CLIMB_NONE)
 	{
 		return false;
 	}
-	
-	TopHit = GetTopHit(FwdHit, GetOwner()->GetActorForwardVector(), GetTraceOrigin());
-	if(!TopHit.IsValidBlockingHit())
+
+	const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	if(Movement == nullptr || !Movement->IsFalling() || Movement->Velocity.Z > 0.f)
 	{
 		return false;
 	}
 
+	BatchedProbe.Frame = GFrameCounter;
+	BatchedProbe.Velocity = Movement->Velocity;
+	// Characters still falling towards a predicted ledge only need the proximity test this frame
+	BatchedProbe.bSearchLedge = !CanPrefetchLedges() || !Prefetch.Ledge.IsValid() || GetTraceOrigin().Z <= Prefetch.GrabZ;
 	return true;
 }
 
-FVector UClimbingComponent::GetCharacterLocationOnLedge(FHitResult FwdHit, FHitResult TopHit) const
+void UClimbingComponent::RunBatchedProbe()
 {
-	FVector TargetLocation = FwdHit.ImpactPoint;
-	TargetLocation.Z = TopHit.ImpactPoint.Z;
-	TargetLocation += FwdHit.Normal.GetSafeNormal2D() * ForwardOffsetFromLedge + FVector::DownVector * VerticalOffsetFromLedge;
-	
-	return TargetLocation;
+	BatchedProbe.bNearLedge = QueryNearClimbableGeometry(BatchedProbe.Velocity);
+	BatchedProbe.bFoundLedge = BatchedProbe.bNearLedge && BatchedProbe.bSearchLedge && FoundLedge(BatchedProbe.FwdHit, BatchedProbe.TopHit);
+}
+
+FVector UClimbingComponent::GetHangLocation(const FVector& WallPoint, float TopZ, const FVector& WallNormal) const
+{
+	return FVector(WallPoint.X, WallPoint.Y, TopZ) + WallNormal.GetSafeNormal2D() * Config->ForwardOffsetFromLedge + FVector::DownVector * Config->VerticalOffsetFromLedge;
+}
+
+FVector UClimbingComponent::GetCharacterLocationOnLedge(const FHitResult& FwdHit, const FHitResult& TopHit) const
+{
+	return GetHangLocation(FwdHit.ImpactPoint, TopHit.ImpactPoint.Z, FwdHit.Normal);
+}
+
+FVector UClimbingComponent::GetCharacterLocationOnEdge(const FLedgeGrabPoint& EdgePoint) const
+{
+	return GetHangLocation(EdgePoint.Location, EdgePoint.Location.Z, EdgePoint.Normal);
 }
 
-FRotator UClimbingComponent::GetCharacterRotationOnLedge(FHitResult FwdHit) const
+FRotator UClimbingComponent::GetCharacterRotationOnEdge(const FLedgeGrabPoint& EdgePoint) const
+{
+	return FRotationMatrix::MakeFromZX(FVector::UpVector, -EdgePoint.Normal.GetSafeNormal2D()).Rotator();
+}
+
+FRotator UClimbingComponent::GetCharacterRotationOnLedge(const FHitResult& FwdHit) const
 {
 	const FRotator TargetRotation = FRotationMatrix::MakeFromZX(FVector::UpVector, -FwdHit.Normal.GetSafeNormal2D()).Rotator();
 	return TargetRotation;
 }
 
-TArray<USceneComponent*> UClimbingComponent::GetReachableGrabPoints(FVector MoveDirection) const
+void UClimbingComponent::CollectReachableGrabPoints(const TArray<FOverlapResult>& Overlaps, const FVector& MoveDirection, TArray<FLedgeGrabPoint>& OutGrabPoints) const
 {
-	TArray<USceneComponent*> ClosestPoints;
-	TArray<FOverlapResult> Overlapped;
-	const FCollisionShape SphereShape = FCollisionShape::MakeSphere(MaxRangeToFindLedge);
-	if(GetWorld()->OverlapMultiByChannel(Overlapped, GetTraceOrigin(), FQuat::Identity, static_cast<ECollisionChannel>(TraceChannel.GetValue()), SphereShape))
+	OutGrabPoints.Reset();
+
+	const FVector CharLocation = GetOwner()->GetActorLocation();
+	TArray<const ALedge*, TInlineAllocator<16>> VisitedLedges;
+	for (const FOverlapResult& OverlapResult : Overlaps)
 	{
-		const FVector CharLocation = GetOwner()->GetActorLocation();
-		for (FOverlapResult OverlapResult : Overlapped)
+		const ALedge* Ledge = Cast<ALedge>(OverlapResult.GetActor());
+		FLedgeGrabPoint Candidate;
+		if(Ledge != nullptr && !VisitedLedges.Contains(Ledge) && Ledge->GetClosestGrabPoint(CharLocation, Candidate))
 		{
-			const ALedge* Ledge = Cast<ALedge>(OverlapResult.GetActor());
-			if(Ledge != nullptr)
+			VisitedLedges.Add(Ledge);
+			FVector LaunchDirection = Candidate.Location - CharLocation;
+			if(FVector::DotProduct(MoveDirection.GetSafeNormal2D(), LaunchDirection.GetSafeNormal2D()) > FMath::Cos(FMath::DegreesToRadians(Config->MaxAngleToLaunch)))
 			{
-				USceneComponent* Candidate = Ledge->GetClosestPoint(GetOwner()->GetActorLocation());
-				FVector LaunchDirection = Candidate->GetComponentLocation() - CharLocation;
-				if(FVector::DotProduct(MoveDirection.GetSafeNormal2D(), LaunchDirection.GetSafeNormal2D()) > FMath::Cos(FMath::DegreesToRadians(MaxAngleToLaunch)))
-				{
-					ClosestPoints.Add(Candidate);
-				}
+				OutGrabPoints.Add(Candidate);
 			}
 		}
 	}
-	
-	return ClosestPoints;
 }
 
-bool UClimbingComponent::GetValidLaunchVelocity(TArray<USceneComponent*> GrabPoints, FVector& LaunchVelocity, const float Gravity) const
+bool UClimbingComponent::GetValidLaunchVelocity(const TArray<FLedgeGrabPoint>& GrabPoints, FVector& LaunchVelocity, const float Gravity) const
 {
 	const FVector GrabLocation = GetTraceOrigin();
 	float ClosestDistance = 1000000000000.f;
-	const USceneComponent* Destination = nullptr;
-	for (const USceneComponent* Point : GrabPoints)
+	const FLedgeGrabPoint* Destination = nullptr;
+	for (const FLedgeGrabPoint& Point : GrabPoints)
 	{
-		const float distance = FVector::Distance(GrabLocation, Point->GetComponentLocation());
-		if(distance < ClosestDistance && distance > MinDistanceToSuggestVelocity)
+		const float distance = FVector::Distance(GrabLocation, Point.Location);
+		if(distance < ClosestDistance && distance > Config->MinDistanceToSuggestVelocity)
 		{
 			FVector TossVelocity;
 			if(IsPossibleToReach(Point, TossVelocity, Gravity))
 			{
 				LaunchVelocity = TossVelocity;
-				Destination = Point;
+				Destination = &Point;
 				ClosestDistance = distance;
 			}
 		}
@@ -202,17 +514,14 @@ bool UClimbingComponent::CanClimbUp(FVector& TargetClimbLocation) const
 		FVector Start = TopHit.ImpactPoint + FVector::UpVector * 90.f + GetOwner()->GetActorForwardVector().GetSafeNormal2D() * 42.f;
 		FVector End = Start + FVector::DownVector * 130.f;
 		FHitResult GroundHit;
-		if(GetWorld()->LineTraceSingleByChannel(GroundHit, Start, End, ECC_Visibility))
+		if(GetWorld()->LineTraceSingleByChannel(GroundHit, Start, End, ECC_Visibility, GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbUpGround))))
 		{			
 			TargetClimbLocation = GroundHit.ImpactPoint;
-			TargetClimbLocation += ClimbUpOffset.X * GetOwner()->GetActorForwardVector();
-			TargetClimbLocation += FVector::UpVector * ClimbUpOffset.Z;
-
-			float CapsuleHalfHeight = CapsuleComponent->GetScaledCapsuleHalfHeight();
-			float CapsuleRadius = CapsuleComponent->GetScaledCapsuleRadius();
-			
-			return !GetWorld()->OverlapAnyTestByChannel(TargetClimbLocation + FVector::UpVector * CapsuleHalfHeight, FQuat::Identity,
-				ECC_Visibility, FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight));
+			TargetClimbLocation += Config->ClimbUpOffset.X * GetOwner()->GetActorForwardVector();
+			TargetClimbLocation += FVector::UpVector * Config->ClimbUpOffset.Z;
+
+			const float CapsuleHalfHeight = CapsuleComponent->GetScaledCapsuleHalfHeight();
+			return !IsCapsuleBlockedAt(TargetClimbLocation + FVector::UpVector * CapsuleHalfHeight, FQuat::Identity, SCENE_QUERY_STAT_ONLY(ClimbUpRoom));
 		}
 	}
 
@@ -230,38 +539,24 @@ bool UClimbingComponent::CanMoveInDirection(float HorizontalDirection, AActor* C
 	FVector ForwardVector = GetOwner()->GetActorForwardVector();
 	FVector RightVector = GetOwner()->GetActorRightVector();
 
-	FVector StartTrace = GetTraceOrigin() + RightVector * Direction * MinSideDistance ;
-	FVector EndTrace = StartTrace + ForwardVector * MaxTraceDistance;
+	FVector StartTrace = GetTraceOrigin() + RightVector * Direction * Config->MinSideDistance ;
+	FVector EndTrace = StartTrace + ForwardVector * Config->MaxTraceDistance;
 
-	TArray<FHitResult> Hits;
-	if(UKismetSystemLibrary::CapsuleTraceMulti(GetWorld(), StartTrace, EndTrace, 1.f, CapsuleTraceHeight, TraceChannel, true,
-		TArray<AActor*>(), DebugTrace ? EDrawDebugTrace::ForOneFrame : EDrawDebugTrace::None, Hits, true))
+	const FCollisionShape Shape = FCollisionShape::MakeCapsule(1.f, Config->CapsuleTraceHeight);
+	FHitResult Hit;
+	if(SweepLedge(CurrentLedgeActor, Hit, StartTrace, EndTrace, Shape))
 	{
-		for (FHitResult Hit : Hits)
-		{
-			if(Hit.GetActor() == CurrentLedgeActor)
-			{
-				return true;
-			}
-		}
+		return true;
 	}
 
-	StartTrace += ForwardVector * (ForwardOffsetFromLedge + 1.f);
-	EndTrace = StartTrace - RightVector * Direction * MinSideDistance;
+	StartTrace += ForwardVector * (Config->ForwardOffsetFromLedge + 1.f);
+	EndTrace = StartTrace - RightVector * Direction * Config->MinSideDistance;
 
-	if(UKismetSystemLibrary::CapsuleTraceMulti(GetWorld(), StartTrace, EndTrace, 1.f, CapsuleTraceHeight, TraceChannel, true,
-		TArray<AActor*>(), DebugTrace ? EDrawDebugTrace::ForOneFrame : EDrawDebugTrace::None, Hits, true, FLinearColor::Blue))
+	if(SweepLedge(CurrentLedgeActor, Hit, StartTrace, EndTrace, Shape))
 	{
-		for (FHitResult Hit : Hits)
-		{
-			if(Hit.GetActor() == CurrentLedgeActor)
-			{
-				Hit.ImpactNormal = -ForwardVector;
-				Hit.ImpactPoint = Hit.ImpactPoint - RightVector * Direction * MinSideDistance;
-				TargetEdgeLocation = GetCharacterLocationOnLedge(Hit, Hit);				
-				break;
-			}
-		}
+		Hit.ImpactNormal = -ForwardVector;
+		Hit.ImpactPoint = Hit.ImpactPoint - RightVector * Direction * Config->MinSideDistance;
+		TargetEdgeLocation = GetCharacterLocationOnLedge(Hit, Hit);
 	}
 	
 	return false;
@@ -278,24 +573,22 @@ bool UClimbingComponent::CanCornerOut(float MoveDirection, FVector& CornerLocati
 	FVector ForwardVector = GetOwner()->GetActorForwardVector();
 	FVector RightVector = GetOwner()->GetActorRightVector();
 
-	FVector StartTrace = GetTraceOrigin() + RightVector * Direction * MinSideDistance * 2.f;
-	FVector EndTrace = StartTrace + ForwardVector * MaxTraceDistance;
+	FVector StartTrace = GetTraceOrigin() + RightVector * Direction * Config->MinSideDistance * 2.f;
+	FVector EndTrace = StartTrace + ForwardVector * Config->MaxTraceDistance;
 	
-	StartTrace += ForwardVector * (ForwardOffsetFromLedge + CornerOutDepth);
-	EndTrace = StartTrace - RightVector * Direction * MinSideDistance * 2.f;
+	StartTrace += ForwardVector * (Config->ForwardOffsetFromLedge + Config->CornerOutDepth);
+	EndTrace = StartTrace - RightVector * Direction * Config->MinSideDistance * 2.f;
 
-	TArray<FHitResult> Hits;
-	if(UKismetSystemLibrary::CapsuleTraceMulti(GetWorld(), StartTrace, EndTrace, 1.f, CapsuleTraceHeight, TraceChannel, true,
-		TArray<AActor*>(), DebugTrace ? EDrawDebugTrace::ForOneFrame : EDrawDebugTrace::None, Hits, true, FLinearColor::Blue))
+	if(SweepClimbableMulti(StartTrace, EndTrace, FCollisionShape::MakeCapsule(1.f, Config->CapsuleTraceHeight)))
 	{
 		float HeightDelta = 10000.0f;
-		FVector CurrentTopHitLocation = GetOwner()->GetActorLocation() + FVector::UpVector * VerticalOffsetFromLedge;
+		FVector CurrentTopHitLocation = GetOwner()->GetActorLocation() + FVector::UpVector * Config->VerticalOffsetFromLedge;
+		FHitResult topHit;
 		FHitResult SelectedTopHit;
-		FHitResult SelectedFwdHit;
-		for (FHitResult Hit : Hits)
+		const FHitResult* SelectedFwdHit = nullptr;
+		for (const FHitResult& Hit : QueryContext.SweepHits)
 		{
-			FHitResult topHit = GetTopHit(Hit, - RightVector * Direction, StartTrace);
-			if(!topHit.IsValidBlockingHit())
+			if(!GetTopHit(topHit, Hit, - RightVector * Direction, StartTrace))
 			{
 				continue;
 			}
@@ -304,16 +597,16 @@ bool UClimbingComponent::CanCornerOut(float MoveDirection, FVector& CornerLocati
 			if(newHeightDelta < HeightDelta)
 			{
 				SelectedTopHit = topHit;
-				SelectedFwdHit = Hit;
+				SelectedFwdHit = &Hit;
 				HeightDelta = newHeightDelta;
 			}
 		}
 
-		if(SelectedTopHit.IsValidBlockingHit())
+		if(SelectedFwdHit != nullptr)
 		{
-			CornerLocation = GetCharacterLocationOnLedge(SelectedFwdHit, SelectedTopHit);
+			CornerLocation = GetCharacterLocationOnLedge(*SelectedFwdHit, SelectedTopHit);
 			CAPSULE(CornerLocation, FColor::Orange);
-			CornerRotation = GetCharacterRotationOnLedge(SelectedFwdHit);
+			CornerRotation = GetCharacterRotationOnLedge(*SelectedFwdHit);
 			return true;
 		}
 	}
@@ -321,20 +614,50 @@ bool UClimbingComponent::CanCornerOut(float MoveDirection, FVector& CornerLocati
 	return false;
 }
 
-bool UClimbingComponent::CanHopUp(FVector& TargetLocation) const
+bool UClimbingComponent::FindLedgeCorner(const ALedge* Ledge, float MoveDirection, FVector& CornerLocation, FRotator& CornerRotation, bool& bInside) const
 {
-	const float Height = MaxHopUpHeight * 0.5f;
-	const FVector Origin = GetTraceOrigin() + FVector::UpVector * Height;
-	const FVector Forward = GetOwner()->GetActorForwardVector();
-	
-	FHitResult FwdHit = GetForwardHit(Origin, Forward, Height);
-	if(!FwdHit.IsValidBlockingHit())
+	if(FMath::Abs(MoveDirection) < 0.1f)
 	{
 		return false;
 	}
 
-	FHitResult TopHit = GetTopHit(FwdHit, Forward, Origin);
-	if(!TopHit.IsValidBlockingHit())
+	bInside = false;
+	FLedgeGrabPoint Point;
+	if(Ledge == nullptr || Ledge->GetFaces().Num() == 0 || !Ledge->GetClosestGrabPoint(GetTraceOrigin(), Point))
+	{
+		return CanCornerOut(MoveDirection, CornerLocation, CornerRotation);
+	}
+
+	// Only the end grab point of a face leads around its corner
+	const int32 FaceIndex = Ledge->GetFaceOfGrabPoint(Point.Index);
+	const FLedgeFace& Face = Ledge->GetFaces()[FaceIndex];
+	const FLedgeCorner* Corner = Ledge->FindCorner(Point.Index, MoveDirection);
+	if(Corner == nullptr || Point.Index != (MoveDirection > 0.f ? Face.RightPoint : Face.LeftPoint))
+	{
+		return false;
+	}
+
+	CornerLocation = GetCharacterLocationOnEdge(Corner->Target);
+	CornerRotation = Corner->TargetRotation;
+	bInside = Corner->Type == ELedgeCornerType::In;
+
+	// The table only knows about ledges, one overlap makes sure nothing else took the spot since
+	const bool bBlocked = IsCapsuleBlockedAt(CornerLocation, CornerRotation.Quaternion(), SCENE_QUERY_STAT_ONLY(LedgeCornerRoom));
+	if(DebugTrace)
+	{
+		CAPSULE(CornerLocation, bBlocked ? FColor::Red : FColor::Orange);
+	}
+	return !bBlocked;
+}
+
+bool UClimbingComponent::CanHopUp(FVector& TargetLocation) const
+{
+	const float Height = Config->MaxHopUpHeight * 0.5f;
+	const FVector Origin = GetTraceOrigin() + FVector::UpVector * Height;
+	const FVector Forward = GetOwner()->GetActorForwardVector();
+	
+	FHitResult FwdHit, TopHit;
+	if(!GetForwardHit(FwdHit, Origin, Forward, Height) || !GetTopHit(TopHit, FwdHit, Forward, Origin))
 	{
 		return false;
 	}
@@ -344,65 +667,75 @@ bool UClimbingComponent::CanHopUp(FVector& TargetLocation) const
 	return true;
 }
 
+int32 UClimbingComponent::GetNumSideLedgeSteps(float& OutStep) const
+{
+	const int32 Iterations = FMath::Max(FMath::FloorToInt(Config->MaxSideJumpDistance / (Config->CapsuleTraceRadius * 2)), 1);
+	OutStep = Config->MaxSideJumpDistance / Iterations;
+	return Iterations + 1;
+}
+
+FVector UClimbingComponent::GetSideLedgeTraceStart(const FVector& SideDirection, const FVector& Forward) const
+{
+	return GetTraceOrigin() + SideDirection * Config->CapsuleTraceRadius - Forward * 10;
+}
+
 bool UClimbingComponent::FoundSideLedge(AActor* CurrentLedge, FVector SideDirection, FVector& LaunchSpeed, float Gravity, float& Duration) const
 {
-	FVector Forward = GetOwner()->GetActorForwardVector();
-	FVector FirstStartTrace = GetTraceOrigin() + SideDirection * CapsuleTraceRadius - Forward *10;
-	const int Iterations = MaxSideJumpDistance / (CapsuleTraceRadius * 2);
-	const float Step = MaxSideJumpDistance / Iterations;
-	for (int i=0; i <= Iterations; i++)
+	const FVector Forward = GetOwner()->GetActorForwardVector();
+	const FVector FirstStartTrace = GetSideLedgeTraceStart(SideDirection, Forward);
+	float Step;
+	const int32 NumSteps = GetNumSideLedgeSteps(Step);
+	FHitResult FwdHit;
+	for (int32 i = 0; i < NumSteps; i++)
 	{
-		FVector StartTrace = FirstStartTrace + SideDirection * i * Step;
-		FHitResult FwdHit = GetForwardHit(StartTrace, Forward, MaxTraceHeight);
-		if(!FwdHit.IsValidBlockingHit() || FwdHit.GetActor() == CurrentLedge)
+		const FVector StartTrace = FirstStartTrace + SideDirection * i * Step;
+		if(GetForwardHit(FwdHit, StartTrace, Forward, Config->MaxTraceHeight) && TestSideLedgeStep(FwdHit, CurrentLedge, Forward, StartTrace, Gravity, LaunchSpeed, Duration))
 		{
-			continue;
+			return true;
 		}
+	}
+	
+	return false;
+}
 
-		FHitResult TopHit = GetTopHit(FwdHit, Forward, StartTrace);
-		if(!TopHit.IsValidBlockingHit())
-		{
-			continue;
-		}
+bool UClimbingComponent::TestSideLedgeStep(const FHitResult& FwdHit, const AActor* CurrentLedge, const FVector& Forward, const FVector& StartTrace, float Gravity, FVector& LaunchSpeed, float& Duration) const
+{
+	FHitResult TopHit;
+	if(!FwdHit.IsValidBlockingHit() || FwdHit.GetActor() == CurrentLedge || !GetTopHit(TopHit, FwdHit, Forward, StartTrace))
+	{
+		return false;
+	}
 
-		ALedge* Ledge = Cast<ALedge>(TopHit.GetActor());
-		if(Ledge != nullptr)
-		{
-			USceneComponent* ClosestPoint = Ledge->GetClosestPoint(TopHit.ImpactPoint);
-			TopHit.ImpactPoint = ClosestPoint->GetComponentLocation();
-			FwdHit.Normal = ClosestPoint->GetForwardVector();
-		}
+	const ALedge* Ledge = Cast<ALedge>(TopHit.GetActor());
+	FLedgeGrabPoint ClosestPoint;
+	FVector EndLocation = GetCharacterLocationOnLedge(FwdHit, TopHit);
+	if(Ledge != nullptr && Ledge->GetClosestGrabPoint(TopHit.ImpactPoint, ClosestPoint))
+	{
+		EndLocation = GetCharacterLocationOnEdge(ClosestPoint);
+	}
 
-		FVector StartLocation = GetOwner()->GetActorLocation();
-		FVector EndLocation = GetCharacterLocationOnLedge(FwdHit, TopHit);
-		if(FoundSuggestVelocity(LaunchSpeed, StartLocation, EndLocation, MaxJumpSpeed, Gravity))
-		{
-			float MaxHeight = -FMath::Pow(LaunchSpeed.Y, 2) / (2*Gravity);
-			float DisplacementY = (EndLocation - StartLocation).Y;
-			Duration = FMath::Sqrt(-2 * MaxHeight / Gravity) + FMath::Sqrt(2 * (DisplacementY - MaxHeight) / Gravity);			
-			return true;
-		}
+	FVector StartLocation = GetOwner()->GetActorLocation();
+	if(FoundSuggestVelocity(LaunchSpeed, StartLocation, EndLocation, Config->MaxJumpSpeed, Gravity))
+	{
+		float MaxHeight = -FMath::Pow(LaunchSpeed.Y, 2) / (2*Gravity);
+		float DisplacementY = (EndLocation - StartLocation).Y;
+		Duration = FMath::Sqrt(-2 * MaxHeight / Gravity) + FMath::Sqrt(2 * (DisplacementY - MaxHeight) / Gravity);			
+		return true;
 	}
-	
+
 	return false;
 }
 
 FVector UClimbingComponent::GetJumpUpVelocity(float Gravity) const
 {
-	FVector DefaultVelocity = FVector::UpVector * MaxJumpUpVelocity;
+	FVector DefaultVelocity = FVector::UpVector * Config->MaxJumpUpVelocity;
 	
-	const float Height = MaxHopUpHeight * 0.5f;
+	const float Height = Config->MaxHopUpHeight * 0.5f;
 	const FVector Origin = GetTraceOrigin() + FVector::UpVector * Height;
 	const FVector Forward = GetOwner()->GetActorForwardVector();
 	
-	FHitResult FwdHit = GetForwardHit(Origin, Forward, Height);
-	if(!FwdHit.IsValidBlockingHit())
-	{
-		return DefaultVelocity;
-	}
-
-	FHitResult TopHit = GetTopHit(FwdHit, Forward, Origin);
-	if(!TopHit.IsValidBlockingHit())
+	FHitResult FwdHit, TopHit;
+	if(!GetForwardHit(FwdHit, Origin, Forward, Height) || !GetTopHit(TopHit, FwdHit, Forward, Origin))
 	{
 		return DefaultVelocity;
 	}
@@ -410,7 +743,7 @@ FVector UClimbingComponent::GetJumpUpVelocity(float Gravity) const
 	FVector StartLocation = GetOwner()->GetActorLocation();
 	FVector EndLocation = GetCharacterLocationOnLedge(FwdHit, TopHit);
 	FVector TossVelocity;
-	if(FoundSuggestVelocity(TossVelocity, StartLocation, EndLocation, MaxJumpUpVelocity, Gravity))
+	if(FoundSuggestVelocity(TossVelocity, StartLocation, EndLocation, Config->MaxJumpUpVelocity, Gravity))
 	{
 		return TossVelocity;
 	}
@@ -418,4 +751,314 @@ FVector UClimbingComponent::GetJumpUpVelocity(float Gravity) const
 	return DefaultVelocity;
 }
 
+FVector UClimbingComponent::GetSideJumpFallbackVelocity(const FVector& SideDirection) const
+{
+	return SideDirection * Config->SideJumpFallbackSpeed + FVector::UpVector * Config->SideJumpFallbackUpSpeed;
+}
+
+float UClimbingComponent::GetMaxClimbJumpSpeed() const
+{
+	const float FallbackSpeed = FVector2D(Config->SideJumpFallbackSpeed, Config->SideJumpFallbackUpSpeed).Size();
+	return FMath::Max3(Config->MaxJumpSpeed, Config->MaxJumpUpVelocity, FallbackSpeed);
+}
+
+bool UClimbingComponent::UpdateLedgePrefetch(const FVector& Velocity, float GravityZ, const AActor* IgnoredLedge, bool& bOutReached)
+{
+	bOutReached = false;
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float Elapsed = Now - Prefetch.Time;
+	const FVector ExpectedVelocity = Prefetch.Velocity + FVector::UpVector * GravityZ * Elapsed;
+	if(!Prefetch.bPredicted || Elapsed > Config->PrefetchLookahead * 0.5f || !Velocity.Equals(ExpectedVelocity, Config->PrefetchVelocityTolerance))
+	{
+		PredictLedge(Velocity, GravityZ, IgnoredLedge);
+	}
+
+	const ALedge* Ledge = Prefetch.Ledge.Get();
+	if(Ledge == nullptr)
+	{
+		return false;
+	}
+
+	const FVector Origin = GetTraceOrigin();
+	if(Origin.Z > Prefetch.GrabZ)
+	{
+		return true;
+	}
+
+	// Reached the grab height, which also catches thin ledges passed between two ticks. The probes still have the final say
+	FLedgeGrabPoint Point;
+	const bool bInReach = Ledge->GetClosestGrabPoint(Origin, Point) && FVector::DistSquared2D(Origin, Point.Location) <= FMath::Square(Config->MaxTraceDistance + Config->CapsuleTraceRadius);
+	ResetLedgePrefetch();
+	bOutReached = bInReach;
+	return bInReach;
+}
+
+void UClimbingComponent::PredictLedge(const FVector& Velocity, float GravityZ, const AActor* IgnoredLedge)
+{
+	ResetLedgePrefetch();
+	Prefetch.bPredicted = true;
+	Prefetch.Velocity = Velocity;
+	Prefetch.Time = GetWorld()->GetTimeSeconds();
+
+	const ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+	if(Registry == nullptr)
+	{
+		return;
+	}
+
+	const FVector Origin = GetTraceOrigin();
+	const FVector Gravity = FVector::UpVector * GravityZ;
+	const FVector Forward = GetOwner()->GetActorForwardVector().GetSafeNormal2D();
+	const float GrabHeight = FMath::Min(Config->MaxTraceHeight, Config->CapsuleTraceHeight);
+	const float Reach = Config->MaxTraceDistance + Config->CapsuleTraceRadius;
+	const float Step = Config->PrefetchLookahead / Config->PrefetchSegments;
+
+	ULedgeRegistry::FLedgeList Ledges;
+	FVector SegmentStart = Origin;
+	for(int32 Segment = 1; Segment <= Config->PrefetchSegments; Segment++)
+	{
+		const float Time = Step * Segment;
+		const FVector SegmentEnd = Origin + Velocity * Time + 0.5f * Gravity * Time * Time;
+
+		Ledges.Reset();
+		Registry->GatherLedges(FBox(SegmentStart, SegmentStart).ExpandBy(Reach) + FBox(SegmentEnd, SegmentEnd).ExpandBy(Reach), Ledges);
+
+		float BestAlpha = TNumericLimits<float>::Max();
+		for (ALedge* Ledge : Ledges)
+		{
+			FLedgeGrabPoint Point;
+			if(Ledge == IgnoredLedge || !Ledge->GetClosestGrabPoint((SegmentStart + SegmentEnd) * 0.5f, Point))
+			{
+				continue;
+			}
+
+			// Where the path crosses the height at which the forward and top probes would find this ledge
+			const float GrabZ = Point.Location.Z + GrabHeight;
+			if(SegmentStart.Z < GrabZ || SegmentEnd.Z > GrabZ || SegmentStart.Z <= SegmentEnd.Z)
+			{
+				continue;
+			}
+
+			const float Alpha = (SegmentStart.Z - GrabZ) / (SegmentStart.Z - SegmentEnd.Z);
+			const FVector Crossing = FMath::Lerp(SegmentStart, SegmentEnd, Alpha);
+			const FVector Normal = Point.Normal.GetSafeNormal2D();
+			if(Alpha < BestAlpha && FVector::DistSquared2D(Crossing, Point.Location) <= FMath::Square(Reach)
+				&& FVector::DotProduct(Crossing - Point.Location, Normal) > 0.f && FVector::DotProduct(Forward, -Normal) > 0.5f)
+			{
+				BestAlpha = Alpha;
+				Prefetch.Ledge = Ledge;
+				Prefetch.Point = Point;
+				Prefetch.GrabZ = GrabZ;
+			}
+		}
+
+		if(Prefetch.Ledge.IsValid())
+		{
+			if(DebugTrace)
+			{
+				POINT(Prefetch.Point.Location, FColor::Cyan);
+			}
+			return;
+		}
+
+		SegmentStart = SegmentEnd;
+	}
+}
+
+UClimbingQueryScheduler* UClimbingComponent::GetQueryScheduler() const
+{
+	return GetWorld()->GetSubsystem<UClimbingQueryScheduler>();
+}
+
+UClimbingProbeBatch* UClimbingComponent::GetProbeBatch() const
+{
+	return GetWorld()->GetSubsystem<UClimbingProbeBatch>();
+}
+
+EClimbingQueryPriority UClimbingComponent::GetQueryPriority() const
+{
+	return UClimbingQueryScheduler::GetPriorityFor(GetOwner());
+}
+
+void UClimbingComponent::RequestReachableGrabPoints(const FVector& MoveDirection, FGrabPointsCallback&& OnComplete)
+{
+	FOverlapDelegate OnOverlap = FOverlapDelegate::CreateWeakLambda(this, [this, Serial = RequestSerial, MoveDirection, OnComplete = MoveTemp(OnComplete)](const FTraceHandle& Handle, FOverlapDatum& Datum)
+	{
+		if(Serial != RequestSerial)
+		{
+			return;
+		}
+
+		GetQueryScheduler()->Enqueue(this, GetQueryPriority(), [this, MoveDirection, OnComplete, Overlaps = MoveTemp(Datum.OutOverlaps)]()
+		{
+			TArray<FLedgeGrabPoint> GrabPoints;
+			CollectReachableGrabPoints(Overlaps, MoveDirection, GrabPoints);
+			OnComplete(GrabPoints);
+		});
+	});
+
+	// Results are collected by the physics scene and handed back at the start of the next frame
+	const FCollisionShape SphereShape = FCollisionShape::MakeSphere(Config->MaxRangeToFindLedge);
+	const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbReachAsync));
+	if(bUseLedgeProxies)
+	{
+		GetWorld()->AsyncOverlapByObjectType(GetTraceOrigin(), FQuat::Identity, ClimbProxyObjectParams, SphereShape, Params, &OnOverlap);
+	}
+	else
+	{
+		GetWorld()->AsyncOverlapByChannel(GetTraceOrigin(), FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel), SphereShape, Params,
+			FCollisionResponseParams::DefaultResponseParam, &OnOverlap);
+	}
+}
+
+void UClimbingComponent::RequestLaunchVelocity(const FVector& MoveDirection, float Gravity, FLaunchCallback&& OnComplete)
+{
+	RequestReachableGrabPoints(MoveDirection, [this, Gravity, OnComplete = MoveTemp(OnComplete)](const TArray<FLedgeGrabPoint>& GrabPoints)
+	{
+		FVector LaunchVelocity = FVector::ZeroVector;
+		const bool bFound = GetValidLaunchVelocity(GrabPoints, LaunchVelocity, Gravity);
+		OnComplete(bFound, LaunchVelocity);
+	});
+}
+
+void UClimbingComponent::RequestSideLedge(AActor* CurrentLedge, const FVector& SideDirection, float Gravity, FSideLedgeCallback&& OnComplete)
+{
+	const TSharedRef<FSideLedgeSearch> Search = MakeShared<FSideLedgeSearch>();
+	Search->CurrentLedge = CurrentLedge;
+	Search->SideDirection = SideDirection;
+	Search->Forward = GetOwner()->GetActorForwardVector();
+	Search->FirstStartTrace = GetSideLedgeTraceStart(SideDirection, Search->Forward);
+	Search->Gravity = Gravity;
+	Search->RequestSerial = RequestSerial;
+	Search->OnComplete = MoveTemp(OnComplete);
+	Search->FwdHits.SetNum(GetNumSideLedgeSteps(Search->Step));
+	Search->NumPendingSweeps = Search->FwdHits.Num();
+
+	// The forward sweeps don't depend on each other, so they all go out at once and come back together next frame
+	FTraceDelegate OnSweep = FTraceDelegate::CreateWeakLambda(this, [this, Search](const FTraceHandle& Handle, FTraceDatum& Datum)
+	{
+		if(Datum.OutHits.Num() > 0)
+		{
+			Search->FwdHits[Datum.UserData] = Datum.OutHits[0];
+		}
+
+		if(--Search->NumPendingSweeps == 0 && Search->RequestSerial == RequestSerial)
+		{
+			ScheduleSideLedgeStep(Search);
+		}
+	});
+
+	const FCollisionShape Shape = FCollisionShape::MakeCapsule(Config->CapsuleTraceRadius, Config->MaxTraceHeight);
+	for(int32 StepIndex = 0; StepIndex < Search->FwdHits.Num(); StepIndex++)
+	{
+		const FVector Start = Search->FirstStartTrace + SideDirection * StepIndex * Search->Step;
+		const FVector End = Start + Search->Forward * Config->MaxTraceDistance;
+		const FCollisionQueryParams& Params = GetQueryParams(SCENE_QUERY_STAT_ONLY(ClimbSideSweepAsync));
+		if(bUseLedgeProxies)
+		{
+			GetWorld()->AsyncSweepByObjectType(EAsyncTraceType::Single, Start, End, FQuat::Identity, ClimbProxyObjectParams, Shape, Params, &OnSweep, StepIndex);
+		}
+		else
+		{
+			GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, Start, End, FQuat::Identity, UEngineTypes::ConvertToCollisionChannel(TraceChannel), Shape, Params,
+				FCollisionResponseParams::DefaultResponseParam, &OnSweep, StepIndex);
+		}
+	}
+}
+
+void UClimbingComponent::ScheduleSideLedgeStep(const TSharedRef<FSideLedgeSearch>& Search)
+{
+	// One step with a forward hit per query, so the budget can stop a long search between steps and go on next frame
+	GetQueryScheduler()->Enqueue(this, GetQueryPriority(), [this, Search]()
+	{
+		while(Search->NextStep < Search->FwdHits.Num() && !Search->FwdHits[Search->NextStep].IsValidBlockingHit())
+		{
+			Search->NextStep++;
+		}
 
+		if(Search->NextStep >= Search->FwdHits.Num())
+		{
+			Search->OnComplete(false, FVector::ZeroVector, -1.f);
+			return;
+		}
+
+		const int32 StepIndex = Search->NextStep++;
+		const FVector StartTrace = Search->FirstStartTrace + Search->SideDirection * StepIndex * Search->Step;
+		FVector LaunchVelocity = FVector::ZeroVector;
+		float Duration = -1.f;
+		if(TestSideLedgeStep(Search->FwdHits[StepIndex], Search->CurrentLedge.Get(), Search->Forward, StartTrace, Search->Gravity, LaunchVelocity, Duration))
+		{
+			Search->OnComplete(true, LaunchVelocity, Duration);
+			return;
+		}
+
+		ScheduleSideLedgeStep(Search);
+	});
+}
+
+void UClimbingComponent::CancelRequests()
+{
+	RequestSerial++;
+	if(UClimbingQueryScheduler* Scheduler = GetQueryScheduler())
+	{
+		Scheduler->Cancel(this);
+	}
+}
+
+bool UClimbingComponent::GetHangOnSplineLedge(const ASplineLedge* Ledge, FVector& Location, FRotator& Rotation, float& EdgeDistance) const
+{
+	FLedgeGrabPoint EdgePoint;
+	if(!Ledge->FindClosestEdgePoint(GetTraceOrigin(), EdgePoint, EdgeDistance))
+	{
+		return false;
+	}
+
+	Location = GetCharacterLocationOnEdge(EdgePoint);
+	Rotation = FRotationMatrix::MakeFromZX(FVector::UpVector, -EdgePoint.Normal.GetSafeNormal2D()).Rotator();
+	return true;
+}
+
+bool UClimbingComponent::CanMoveAlongSplineLedge(const ASplineLedge* Ledge, float EdgeDistance, float HorizontalDirection) const
+{
+	if(FMath::Abs(HorizontalDirection) < 0.1f)
+	{
+		return false;
+	}
+
+	// Character right is either along or against the spline depending on which side the wall faces
+	const float Direction = FMath::Sign(HorizontalDirection) * FMath::Sign(FVector::DotProduct(GetOwner()->GetActorRightVector(), Ledge->GetEdgeTangentAtDistance(EdgeDistance)));
+	float CornerDistance;
+	bool bInside;
+	if(Ledge->FindCorner(EdgeDistance, Direction, Config->MinSideDistance, CornerDistance, bInside))
+	{
+		return false;
+	}
+
+	return Ledge->IsDistanceOnEdge(EdgeDistance + Direction * Config->MinSideDistance);
+}
+
+bool UClimbingComponent::FindSplineLedgeCorner(const ASplineLedge* Ledge, float EdgeDistance, float HorizontalDirection, FVector& CornerLocation, FRotator& CornerRotation, bool& bInside) const
+{
+	if(FMath::Abs(HorizontalDirection) < 0.1f)
+	{
+		return false;
+	}
+
+	const float Direction = FMath::Sign(HorizontalDirection) * FMath::Sign(FVector::DotProduct(GetOwner()->GetActorRightVector(), Ledge->GetEdgeTangentAtDistance(EdgeDistance)));
+	float CornerDistance;
+	if(!Ledge->FindCorner(EdgeDistance, Direction, Config->MinSideDistance, CornerDistance, bInside))
+	{
+		return false;
+	}
+
+	const float TargetDistance = CornerDistance + Direction * (bInside ? Config->CornerInDepth : Config->CornerOutDepth);
+	if(!Ledge->IsDistanceOnEdge(TargetDistance))
+	{
+		return false;
+	}
+
+	const FLedgeGrabPoint EdgePoint = Ledge->GetEdgePointAtDistance(TargetDistance);
+	CornerLocation = GetCharacterLocationOnEdge(EdgePoint);
+	CornerRotation = FRotationMatrix::MakeFromZX(FVector::UpVector, -EdgePoint.Normal.GetSafeNormal2D()).Rotator();
+	return true;
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClimbingProbeBatch.h"
+
+#include "ClimbingComponent.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_STATS_GROUP(TEXT("AdventureClimbing"), STATGROUP_AdventureClimbing, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Probe Batch Gather"), STAT_AdventureProbeGather, STATGROUP_AdventureClimbing);
+DECLARE_CYCLE_STAT(TEXT("Probe Batch Execute"), STAT_AdventureProbeExecute, STATGROUP_AdventureClimbing);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Probes"), STAT_AdventureBatchedProbes, STATGROUP_AdventureClimbing);
+
+static TAutoConsoleVariable<bool> CVarClimbingProbeBatch(
+	TEXT("Adventure.ClimbingProbes.Batch"),
+	true,
+	TEXT("Run the falling ledge probes of all climbing components as one parallel pass. Off probes each character inline in its own tick."));
+
+static TAutoConsoleVariable<int32> CVarClimbingProbeMinParallel(
+	TEXT("Adventure.ClimbingProbes.MinParallel"),
+	8,
+	TEXT("Smallest batch that is spread over worker threads, smaller batches run on the game thread."));
+
+void FClimbingProbeBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if(Batch != nullptr && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Batch->Run();
+	}
+}
+
+FString FClimbingProbeBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("UClimbingProbeBatch");
+}
+
+void UClimbingProbeBatch::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Batch = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UClimbingProbeBatch::Deinitialize()
+{
+	if(TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Batch = nullptr;
+	Components.Reset();
+
+	Super::Deinitialize();
+}
+
+void UClimbingProbeBatch::Register(UClimbingComponent* Component)
+{
+	Components.AddUnique(Component);
+	Component->PrimaryComponentTick.AddPrerequisite(this, TickFunction);
+}
+
+void UClimbingProbeBatch::Unregister(UClimbingComponent* Component)
+{
+	Components.RemoveSingleSwap(Component, false);
+	Component->PrimaryComponentTick.RemovePrerequisite(this, TickFunction);
+}
+
+bool UClimbingProbeBatch::IsEnabled()
+{
+	return CVarClimbingProbeBatch.GetValueOnGameThread();
+}
+
+void UClimbingProbeBatch::Run()
+{
+	if(!IsEnabled())
+	{
+		return;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AdventureProbeGather);
+		Gathered.Reset();
+		for (UClimbingComponent* Component : Components)
+		{
+			if(Component->PrepareBatchedProbe())
+			{
+				Gathered.Add(Component);
+			}
+		}
+	}
+
+	if(Gathered.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_AdventureProbeExecute);
+	INC_DWORD_STAT_BY(STAT_AdventureBatchedProbes, Gathered.Num());
+	// Each job only writes its own component's query buffers and result
+	const bool bSingleThreaded = Gathered.Num() < CVarClimbingProbeMinParallel.GetValueOnGameThread();
+	ParallelFor(Gathered.Num(), [this](int32 Index)
+	{
+		Gathered[Index]->RunBatchedProbe();
+	}, bSingleThreaded);
+}
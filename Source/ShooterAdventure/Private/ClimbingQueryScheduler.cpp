@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClimbingQueryScheduler.h"
+
+#include "GameFramework/Pawn.h"
+
+static TAutoConsoleVariable<float> CVarClimbingQueryBudgetMs(
+	TEXT("Adventure.ClimbingQueries.BudgetMs"),
+	1.f,
+	TEXT("Game thread time in milliseconds the climbing query scheduler may spend per frame."));
+
+void UClimbingQueryScheduler::Enqueue(const UObject* Owner, EClimbingQueryPriority Priority, TUniqueFunction<void()>&& Work)
+{
+	Queues[(int32)Priority].Add({ Owner, MoveTemp(Work) });
+}
+
+void UClimbingQueryScheduler::Cancel(const UObject* Owner)
+{
+	// Only clear the owner, a running Tick may be iterating these queues
+	for (TArray<FQuery>& Queue : Queues)
+	{
+		for (FQuery& Query : Queue)
+		{
+			if(Query.Owner.Get() == Owner)
+			{
+				Query.Owner.Reset();
+			}
+		}
+	}
+}
+
+EClimbingQueryPriority UClimbingQueryScheduler::GetPriorityFor(const AActor* Actor)
+{
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if(Pawn == nullptr || !Pawn->IsPlayerControlled())
+	{
+		return EClimbingQueryPriority::AI;
+	}
+
+	return Pawn->IsLocallyControlled() ? EClimbingQueryPriority::LocalPlayer : EClimbingQueryPriority::RemotePlayer;
+}
+
+void UClimbingQueryScheduler::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = CVarClimbingQueryBudgetMs.GetValueOnGameThread() * 0.001;
+	bool bOverBudget = false;
+
+	for (TArray<FQuery>& Queue : Queues)
+	{
+		// Over budget, a priority still gets its first query in, so every non-empty priority moves each frame
+		bool bRanQuery = false;
+		int32 Index = 0;
+		for(; Index < Queue.Num() && !(bOverBudget && bRanQuery); Index++)
+		{
+			if(!Queue[Index].Owner.IsValid())
+			{
+				continue;
+			}
+
+			// Work may enqueue more queries and grow this array, so move it out first
+			TUniqueFunction<void()> Work = MoveTemp(Queue[Index].Work);
+			Work();
+			bRanQuery = true;
+			bOverBudget = FPlatformTime::Seconds() - StartTime > Budget;
+		}
+
+		Queue.RemoveAt(0, Index, false);
+	}
+}
+
+TStatId UClimbingQueryScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UClimbingQueryScheduler, STATGROUP_Tickables);
+}
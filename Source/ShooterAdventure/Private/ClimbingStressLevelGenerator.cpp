@@ -0,0 +1,297 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClimbingStressLevelGenerator.h"
+
+#include "Ledge.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "EngineUtils.h"
+#include "Components/BoxComponent.h"
+
+namespace ClimbingStressLevel
+{
+	constexpr float WallDepth = 100.f;
+	constexpr float HopUpSpacing = 90.f;
+	constexpr float HopUpSetback = 40.f;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GenerateClimbingStressLevelCommand(
+	TEXT("Adventure.ClimbingStressLevel.Generate"),
+	TEXT("Builds a procedural climbing test level. Usage: Adventure.ClimbingStressLevel.Generate [Seed] [GridSize] [Density]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FClimbingStressLevelSettings Settings;
+		if(Args.Num() > 0) LexFromString(Settings.Seed, *Args[0]);
+		if(Args.Num() > 1) LexFromString(Settings.GridSize, *Args[1]);
+		if(Args.Num() > 2) LexFromString(Settings.Density, *Args[2]);
+		AClimbingStressLevelGenerator::SpawnGenerator(World, Settings);
+	}));
+
+static FAutoConsoleCommandWithWorld ClearClimbingStressLevelCommand(
+	TEXT("Adventure.ClimbingStressLevel.Clear"),
+	TEXT("Destroys every generated climbing test level"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for(TActorIterator<AClimbingStressLevelGenerator> It(World); It; ++It)
+		{
+			It->Destroy();
+		}
+	}));
+
+AClimbingStressLevelGenerator::AClimbingStressLevelGenerator()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AClimbingStressLevelGenerator* AClimbingStressLevelGenerator::SpawnGenerator(UWorld* World, const FClimbingStressLevelSettings& InSettings)
+{
+	if(World == nullptr)
+	{
+		return nullptr;
+	}
+
+	AClimbingStressLevelGenerator* Generator = World->SpawnActorDeferred<AClimbingStressLevelGenerator>(StaticClass(), FTransform::Identity);
+	if(Generator)
+	{
+		Generator->Settings = InSettings;
+		Generator->bGenerateOnBeginPlay = true;
+		Generator->FinishSpawning(FTransform::Identity);
+	}
+
+	return Generator;
+}
+
+void AClimbingStressLevelGenerator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if(bGenerateOnBeginPlay)
+	{
+		Generate();
+	}
+}
+
+void AClimbingStressLevelGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Clear();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AClimbingStressLevelGenerator::Generate()
+{
+	Clear();
+
+	NumLedges = 0;
+	NumGrabPoints = 0;
+
+	const int32 GridSize = FMath::Max(Settings.GridSize, 1);
+	const float HalfSize = GridSize * Settings.CellSize * 0.5f;
+	const FVector Origin = GetActorLocation();
+
+	// Floor below the whole grid, its top sits at the generator's height
+	SpawnBlock(FTransform(Origin + FVector(0.f, 0.f, -50.f)), FVector(HalfSize + Settings.CellSize, HalfSize + Settings.CellSize, 50.f));
+
+	for(int32 X = 0; X < GridSize; X++)
+	{
+		for(int32 Y = 0; Y < GridSize; Y++)
+		{
+			const FVector CellOrigin = Origin + FVector((X + 0.5f) * Settings.CellSize - HalfSize, (Y + 0.5f) * Settings.CellSize - HalfSize, 0.f);
+			GenerateCell(FIntPoint(X, Y), CellOrigin);
+		}
+	}
+
+	UE_LOG(LogAdventureMovement, Log, TEXT("Climbing stress level: seed %d, %dx%d cells, %d actors, %d ledges, %d grab points"),
+		Settings.Seed, GridSize, GridSize, GeneratedActors.Num(), NumLedges, NumGrabPoints);
+}
+
+void AClimbingStressLevelGenerator::Clear()
+{
+	for(AActor* Actor : GeneratedActors)
+	{
+		if(IsValid(Actor))
+		{
+			Actor->Destroy();
+		}
+	}
+
+	GeneratedActors.Reset();
+}
+
+void AClimbingStressLevelGenerator::GenerateCell(const FIntPoint& Cell, const FVector& CellOrigin)
+{
+	// Features draw a different number of values, so every cell gets its own stream. A cell's layout then only
+	// depends on the seed, its coordinates and the settings, and toggling a feature leaves the other cells alone.
+	Stream.Initialize(HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Cell)));
+
+	const float Roll = Stream.FRand();
+	const int32 Feature = Stream.RandRange(0, 5);
+	const float Yaw = Stream.RandRange(0, 3) * 90.f;
+	const FVector Jitter(Stream.FRandRange(-0.15f, 0.15f) * Settings.CellSize, Stream.FRandRange(-0.15f, 0.15f) * Settings.CellSize, 0.f);
+
+	if(Roll > Settings.Density)
+	{
+		return;
+	}
+
+	const FTransform Transform(FRotator(0.f, Yaw, 0.f), CellOrigin + Jitter);
+	switch(Feature)
+	{
+	case 0:
+		if(Settings.bWalls) SpawnWall(Transform);
+		break;
+	case 1:
+		if(Settings.bCorners) SpawnCorner(Transform, false);
+		break;
+	case 2:
+		if(Settings.bCorners) SpawnCorner(Transform, true);
+		break;
+	case 3:
+		if(Settings.bHopUpStacks) SpawnHopUpStack(Transform);
+		break;
+	case 4:
+		if(Settings.bSideJumpGaps) SpawnSideJumpGap(Transform);
+		break;
+	default:
+		if(Settings.bSlides) SpawnSlide(Transform);
+		break;
+	}
+}
+
+void AClimbingStressLevelGenerator::SpawnWall(const FTransform& Transform)
+{
+	const float Height = Stream.FRandRange(250.f, 450.f);
+	const float Width = Stream.FRandRange(300.f, 900.f);
+	AddWall(Transform, Height, Width);
+}
+
+ALedge* AClimbingStressLevelGenerator::AddWall(const FTransform& Transform, float Height, float Width)
+{
+	const FVector Extent(ClimbingStressLevel::WallDepth * 0.5f, Width * 0.5f, Height * 0.5f);
+	return SpawnLedge(FTransform(FVector(0.f, 0.f, Extent.Z)) * Transform, Extent);
+}
+
+void AClimbingStressLevelGenerator::SpawnCorner(const FTransform& Transform, bool bInside)
+{
+	const float Height = Stream.FRandRange(250.f, 450.f);
+	const float Width = Stream.FRandRange(300.f, 600.f);
+
+	if(bInside)
+	{
+		// Two walls meeting at a right angle, both faces point into the enclosed corner
+		const FVector Extent(ClimbingStressLevel::WallDepth * 0.5f, Width * 0.5f, Height * 0.5f);
+		SpawnLedge(FTransform(FVector(-Extent.X, 0.f, Extent.Z)) * Transform, Extent);
+		const FVector SideLocation(Width * 0.5f, -Width * 0.5f - Extent.X, Extent.Z);
+		SpawnLedge(FTransform(FRotator(0.f, 90.f, 0.f), SideLocation) * Transform, Extent);
+	}
+	else
+	{
+		// Square pillar climbable on its front and right faces, the outer corner sits between them
+		const FVector Extent(Width * 0.5f, Width * 0.5f, Height * 0.5f);
+		SpawnLedge(FTransform(FVector(0.f, 0.f, Extent.Z)) * Transform, Extent, true);
+	}
+}
+
+void AClimbingStressLevelGenerator::SpawnHopUpStack(const FTransform& Transform)
+{
+	using namespace ClimbingStressLevel;
+
+	const int32 Steps = Stream.RandRange(2, 4);
+	const float BaseHeight = Stream.FRandRange(200.f, 300.f);
+	const float Width = Stream.FRandRange(300.f, 600.f);
+
+	// Each step is set back from the one below so every lip keeps a free top surface
+	for(int32 Step = 0; Step < Steps; Step++)
+	{
+		const float Top = BaseHeight + Step * HopUpSpacing;
+		const float Bottom = Step == 0 ? 0.f : Top - HopUpSpacing;
+		const FVector Extent(WallDepth * 0.5f, Width * 0.5f, (Top - Bottom) * 0.5f);
+		SpawnLedge(FTransform(FVector(-Step * HopUpSetback, 0.f, Bottom + Extent.Z)) * Transform, Extent);
+	}
+}
+
+void AClimbingStressLevelGenerator::SpawnSideJumpGap(const FTransform& Transform)
+{
+	const float Height = Stream.FRandRange(250.f, 400.f);
+	const float Gap = Stream.FRandRange(120.f, 350.f);
+	const float Width = Stream.FRandRange(250.f, 500.f);
+	const FVector Extent(ClimbingStressLevel::WallDepth * 0.5f, Width * 0.5f, Height * 0.5f);
+	const float Offset = (Width + Gap) * 0.5f;
+
+	SpawnLedge(FTransform(FVector(0.f, -Offset, Extent.Z)) * Transform, Extent);
+	SpawnLedge(FTransform(FVector(0.f, Offset, Extent.Z + Stream.FRandRange(-60.f, 60.f))) * Transform, Extent);
+}
+
+void AClimbingStressLevelGenerator::SpawnSlide(const FTransform& Transform)
+{
+	const float Pitch = Stream.FRandRange(15.f, 35.f);
+	const float Length = Stream.FRandRange(600.f, 1000.f);
+	const FVector Extent(Length * 0.5f, 200.f, 20.f);
+
+	// Raise the ramp so its lower end touches the floor
+	const float Rise = FMath::Sin(FMath::DegreesToRadians(Pitch)) * Extent.X;
+	SpawnBlock(FTransform(FRotator(Pitch, 0.f, 0.f), FVector(0.f, 0.f, Rise)) * Transform, Extent, Settings.RampObjectChannel);
+}
+
+AActor* AClimbingStressLevelGenerator::SpawnBlock(const FTransform& Transform, const FVector& Extent, ECollisionChannel ObjectType)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Block = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), Transform, SpawnParams);
+	if(Block == nullptr)
+	{
+		return nullptr;
+	}
+
+	UBoxComponent* Box = NewObject<UBoxComponent>(Block, TEXT("Collision"));
+	Box->SetBoxExtent(Extent, false);
+	Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Box->SetCollisionObjectType(ObjectType);
+	Box->SetHiddenInGame(false);
+	Block->SetRootComponent(Box);
+	Box->SetWorldTransform(Transform);
+	Box->RegisterComponent();
+
+	GeneratedActors.Add(Block);
+	return Block;
+}
+
+ALedge* AClimbingStressLevelGenerator::SpawnLedge(const FTransform& Transform, const FVector& Extent, bool bSideFaceGrabPoints)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	// Ledge ids hash the path name, so a generator with the same name and settings on the server and on a client
+	// builds ledges that resolve to each other over the network
+	SpawnParams.Name = FName(*(GetName() + TEXT("_Ledge")), NumLedges + 1);
+	SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ALedge* Ledge = GetWorld()->SpawnActor<ALedge>(ALedge::StaticClass(), Transform, SpawnParams);
+	if(Ledge == nullptr)
+	{
+		return nullptr;
+	}
+
+	UBoxComponent* Box = NewObject<UBoxComponent>(Ledge, TEXT("Collision"));
+	Box->SetBoxExtent(Extent, false);
+	Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Box->SetCollisionResponseToChannel(Settings.ClimbableChannel, ECR_Block);
+	Box->SetHiddenInGame(false);
+	Box->SetupAttachment(Ledge->GetRootComponent());
+	Box->RegisterComponent();
+	Ledge->FitClimbProxy();
+
+	const float Spacing = FMath::Max(Settings.GrabPointSpacing, 10.f);
+	Ledge->AddGrabPointsAlongEdge(FVector(Extent.X, -Extent.Y, Extent.Z), FVector(Extent.X, Extent.Y, Extent.Z), FVector::ForwardVector, Spacing);
+	if(bSideFaceGrabPoints)
+	{
+		Ledge->AddGrabPointsAlongEdge(FVector(Extent.X, Extent.Y, Extent.Z), FVector(-Extent.X, Extent.Y, Extent.Z), FVector::RightVector, Spacing);
+	}
+	NumGrabPoints += Ledge->GetNumGrabPoints();
+
+	GeneratedActors.Add(Ledge);
+	NumLedges++;
+	return Ledge;
+}
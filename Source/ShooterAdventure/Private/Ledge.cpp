@@ -3,42 +3,271 @@
 
 #include "Ledge.h"
 
+#include "EngineUtils.h"
+#include "LedgeRegistry.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "Components/BoxComponent.h"
+
+const FName ALedge::ClimbProxyProfileName(TEXT("LedgeProxy"));
+
+static FAutoConsoleCommandWithWorld LedgeReportCommand(
+	TEXT("Adventure.Ledges.Report"),
+	TEXT("Logs ledge and grab point counts with their memory"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		int32 NumLedges = 0;
+		int32 NumGrabPoints = 0;
+		int32 NumLegacyComponents = 0;
+		SIZE_T GrabPointBytes = 0;
+		for(TActorIterator<ALedge> It(World); It; ++It)
+		{
+			NumLedges++;
+			NumGrabPoints += It->GetNumGrabPoints();
+			NumLegacyComponents += It->GrabPoints.Num();
+			GrabPointBytes += It->GetGrabPointAllocatedSize();
+		}
+
+		UE_LOG(LogAdventureMovement, Log, TEXT("Ledges: %d, grab points: %d (%.1f KB), legacy grab point components: %d"),
+			NumLedges, NumGrabPoints, GrabPointBytes / 1024.f, NumLegacyComponents);
+	}));
+
 // Sets default values
 ALedge::ALedge()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = false;
 
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	ClimbProxy = CreateDefaultSubobject<UBoxComponent>(TEXT("ClimbProxy"));
+	ClimbProxy->SetupAttachment(RootComponent);
+	ClimbProxy->SetCollisionProfileName(ClimbProxyProfileName);
+	ClimbProxy->SetGenerateOverlapEvents(false);
+	ClimbProxy->SetCanEverAffectNavigation(false);
 }
 
 // Called when the game starts or when spawned
 void ALedge::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// Blueprints may still register component grab points from BeginPlay. Their class components come back on every
+	// load, so they replace the points instead of adding to an earlier bake.
+	if(GrabPoints.Num() > 0)
+	{
+		GrabPointTransforms.Reset();
+		BakeGrabPointComponents();
+	}
+
+	if(ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>())
+	{
+		Registry->RegisterLedge(this);
+	}
+}
+
+void ALedge::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// A level streaming out drops its whole registry partition at once
+	ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+	if(Registry != nullptr && EndPlayReason != EEndPlayReason::RemovedFromWorld)
+	{
+		Registry->UnregisterLedge(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALedge::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	RefreshGrabPoints();
 }
 
-USceneComponent* ALedge::GetClosestPoint(FVector Origin) const
+void ALedge::OnConstruction(const FTransform& Transform)
 {
-	USceneComponent* ClosestPoint = nullptr;
-	float ClosestDistance = 100000000000.0f;
+	Super::OnConstruction(Transform);
+	RefreshGrabPoints();
+
+	if(bAutoFitClimbProxy)
+	{
+		FitClimbProxy();
+	}
+}
+
+void ALedge::FitClimbProxy()
+{
+	// Bounds in actor space of everything that collides, proxies excluded
+	const FTransform WorldToActor = GetActorTransform().Inverse();
+	FBox Bounds(ForceInit);
+	ForEachComponent<UPrimitiveComponent>(false, [&](const UPrimitiveComponent* Component)
+	{
+		if(Component->IsCollisionEnabled() && Component->GetCollisionObjectType() != ClimbProxyChannel)
+		{
+			Bounds += Component->CalcBounds(Component->GetComponentTransform() * WorldToActor).GetBox();
+		}
+	});
+
+	if(Bounds.IsValid)
+	{
+		ClimbProxy->SetRelativeTransform(FTransform(Bounds.GetCenter()));
+		ClimbProxy->SetBoxExtent(Bounds.GetExtent());
+	}
+}
+
+void ALedge::BakeGrabPointComponents()
+{
+	const FTransform WorldToActor = GetActorTransform().Inverse();
 	for (USceneComponent* GrabPoint : GrabPoints)
 	{
-		if(ClosestPoint == nullptr)
+		if(GrabPoint == nullptr)
 		{
-			ClosestPoint = GrabPoint;
+			continue;
 		}
-		else
+
+		GrabPointTransforms.Add(GrabPoint->GetComponentTransform() * WorldToActor);
+
+		// Blueprint-defined components are owned by the class and cannot be destroyed per instance
+		if(GrabPoint->CreationMethod != EComponentCreationMethod::SimpleConstructionScript && GrabPoint != RootComponent)
 		{
-			const float distance = FVector::Distance(Origin, GrabPoint->GetComponentLocation());
-			if(distance < ClosestDistance)
-			{
-				ClosestDistance = distance;
-				ClosestPoint = GrabPoint;
-			}
+			GrabPoint->DestroyComponent();
 		}
 	}
 
-	return ClosestPoint;
+	GrabPoints.Reset();
+	RefreshGrabPoints();
+}
+
+void ALedge::AddGrabPointsAlongEdge(const FVector& LocalStart, const FVector& LocalEnd, const FVector& LocalNormal, float Spacing)
+{
+	const float Length = FVector::Distance(LocalStart, LocalEnd);
+	const int32 Count = FMath::Max(FMath::FloorToInt32(Length / FMath::Max(Spacing, 1.f)), 1);
+	const FVector Step = (LocalEnd - LocalStart) / Count;
+	const FQuat Rotation = LocalNormal.ToOrientationQuat();
+
+	GrabPointTransforms.Reserve(GrabPointTransforms.Num() + Count);
+	for(int32 Index = 0; Index < Count; Index++)
+	{
+		GrabPointTransforms.Add(FTransform(Rotation, LocalStart + Step * (Index + 0.5f)));
+	}
+
+	RefreshGrabPoints();
 }
 
+void ALedge::RefreshGrabPoints()
+{
+	BuildFaces();
+
+	// Runtime edits have to refresh the corner links as well
+	if(HasActorBegunPlay())
+	{
+		if(ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>())
+		{
+			Registry->RegisterLedge(this);
+		}
+	}
+}
+
+void ALedge::BuildFaces()
+{
+	Faces.Reset();
+	PointFaces.Reset(GrabPointTransforms.Num());
+
+	TArray<FVector2f, TInlineAllocator<8>> FaceExtents;
+	for(int32 Index = 0; Index < GrabPointTransforms.Num(); Index++)
+	{
+		const FVector3f Normal(GrabPointTransforms[Index].GetRotation().GetForwardVector());
+		int32 FaceIndex = Faces.IndexOfByPredicate([&Normal](const FLedgeFace& Face) { return (Face.Normal | Normal) > 0.95f; });
+		if(FaceIndex == INDEX_NONE)
+		{
+			FaceIndex = Faces.AddDefaulted();
+			Faces[FaceIndex].Normal = Normal;
+			FaceExtents.Add(FVector2f(TNumericLimits<float>::Max(), TNumericLimits<float>::Lowest()));
+		}
+		PointFaces.Add(FaceIndex);
+
+		// Right of a character facing -Normal
+		FLedgeFace& Face = Faces[FaceIndex];
+		const FVector3f Right = FVector3f::CrossProduct(FVector3f::UpVector, -Face.Normal);
+		const float Along = FVector3f(GrabPointTransforms[Index].GetLocation()) | Right;
+		if(Along < FaceExtents[FaceIndex].X)
+		{
+			FaceExtents[FaceIndex].X = Along;
+			Face.LeftPoint = Index;
+		}
+		if(Along > FaceExtents[FaceIndex].Y)
+		{
+			FaceExtents[FaceIndex].Y = Along;
+			Face.RightPoint = Index;
+		}
+	}
+}
+
+const FLedgeCorner* ALedge::FindCorner(int32 GrabPointIndex, float Direction) const
+{
+	const int32 FaceIndex = GetFaceOfGrabPoint(GrabPointIndex);
+	if(FaceIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const FLedgeCorner& Corner = Faces[FaceIndex].Corners[Direction > 0.f ? FLedgeFace::RightEnd : FLedgeFace::LeftEnd];
+	return Corner.IsValid() ? &Corner : nullptr;
+}
+
+FBox ALedge::GetGrabBounds() const
+{
+	FBox Bounds(ForceInit);
+	const FTransform& ActorTransform = GetActorTransform();
+	for (const FTransform& Transform : GrabPointTransforms)
+	{
+		Bounds += ActorTransform.TransformPosition(Transform.GetLocation());
+	}
+
+	return Bounds;
+}
+
+bool ALedge::GetClosestGrabPoint(FVector Origin, FLedgeGrabPoint& OutPoint) const
+{
+	if(GrabPointTransforms.Num() == 0)
+	{
+		return false;
+	}
+
+	// Search in actor space so the points never need to follow the actor's transform. Offsets are scaled back to
+	// world size, otherwise a non-uniformly scaled ledge would favour points along its stretched axis.
+	const FTransform& ActorTransform = GetActorTransform();
+	const FVector LocalOrigin = ActorTransform.InverseTransformPosition(Origin);
+	const FVector Scale = ActorTransform.GetScale3D();
+	int32 ClosestIndex = 0;
+	double ClosestDistance = TNumericLimits<double>::Max();
+	for(int32 Index = 0; Index < GrabPointTransforms.Num(); Index++)
+	{
+		const double Distance = ((LocalOrigin - GrabPointTransforms[Index].GetLocation()) * Scale).SizeSquared();
+		if(Distance < ClosestDistance)
+		{
+			ClosestDistance = Distance;
+			ClosestIndex = Index;
+		}
+	}
+
+	OutPoint = GetGrabPoint(ClosestIndex);
+	return true;
+}
+
+FLedgeGrabPoint ALedge::GetGrabPoint(int32 Index) const
+{
+	const FTransform& ActorTransform = GetActorTransform();
+
+	FLedgeGrabPoint Point;
+	const FTransform& Transform = GrabPointTransforms[Index];
+	Point.Location = ActorTransform.TransformPosition(Transform.GetLocation());
+	// Normals take the inverse scale so they stay perpendicular to a non-uniformly scaled wall
+	Point.Normal = ActorTransform.TransformVectorNoScale(Transform.GetRotation().GetForwardVector() / ActorTransform.GetScale3D()).GetSafeNormal();
+	Point.Index = Index;
+	return Point;
+}
+
+SIZE_T ALedge::GetGrabPointAllocatedSize() const
+{
+	return GrabPointTransforms.GetAllocatedSize() + Faces.GetAllocatedSize() + PointFaces.GetAllocatedSize();
+}
@@ -0,0 +1,581 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeRegistry.h"
+
+#include "Ledge.h"
+#include "ShooterAdventure/ShooterAdventure.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+namespace LedgeRegistry
+{
+	/** Minimum alignment between the adjacent face normal and the shimmy direction */
+	constexpr float CornerNormalAlignment = 0.7f;
+	constexpr float MaxCornerHeightDelta = 30.f;
+}
+
+static TAutoConsoleVariable<bool> CVarLedgeAsyncPartitionBuild(
+	TEXT("Adventure.Ledges.AsyncPartitionBuild"),
+	true,
+	TEXT("Build the ledge grids of streamed levels on a worker thread. Off registers every ledge inline in its BeginPlay."));
+
+static FAutoConsoleCommandWithWorld LedgePartitionReportCommand(
+	TEXT("Adventure.Ledges.Partitions"),
+	TEXT("Logs ledge counts and grid memory of every loaded ledge registry partition"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if(const ULedgeRegistry* Registry = World->GetSubsystem<ULedgeRegistry>())
+		{
+			Registry->ReportPartitions();
+		}
+	}));
+
+void ULedgeRegistry::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ULedgeRegistry::OnLevelRemoved);
+}
+
+void ULedgeRegistry::Deinitialize()
+{
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	for (FPartitionBuild& Build : Builds)
+	{
+		Build.Task.Wait();
+	}
+
+	Builds.Reset();
+	QueuedSnapshots.Reset();
+	Partitions.Reset();
+	LedgeEntries.Reset();
+	LedgesById.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULedgeRegistry::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	for(int32 Index = Builds.Num() - 1; Index >= 0; Index--)
+	{
+		if(Builds[Index].Task.IsCompleted())
+		{
+			MergePartition(Builds[Index].Level, MoveTemp(Builds[Index].Task.GetResult()));
+			Builds.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	// One build per level and frame, a cell's ledges all begin play in the same frame
+	for (TPair<TObjectKey<ULevel>, TArray<FLedgeSnapshot>>& Pair : QueuedSnapshots)
+	{
+		if(Pair.Value.Num() == 0)
+		{
+			continue;
+		}
+
+		Builds.Add({ Pair.Key, UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshots = MoveTemp(Pair.Value)]()
+		{
+			FPartition Partition;
+			for (const FLedgeSnapshot& Snapshot : Snapshots)
+			{
+				Partition.Add(Snapshot);
+			}
+			return Partition;
+		}) });
+	}
+	QueuedSnapshots.Reset();
+}
+
+TStatId ULedgeRegistry::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULedgeRegistry, STATGROUP_Tickables);
+}
+
+void ULedgeRegistry::RegisterLedge(ALedge* Ledge)
+{
+	if(Ledge == nullptr)
+	{
+		return;
+	}
+
+	UnregisterLedge(Ledge);
+
+	FLedgeSnapshot Snapshot;
+	Snapshot.Ledge = Ledge;
+	Snapshot.Ends = GetEnds(Ledge);
+	Snapshot.Bounds = Ledge->GetGrabBounds();
+	Snapshot.Serial = ++NextSerial;
+
+	// Ids resolve right away, even while the ledge's partition is still being built
+	const uint32 LedgeId = MakeLedgeId(Ledge);
+	if(LedgeId != 0)
+	{
+		auto& Ledges = LedgesById.FindOrAdd(LedgeId);
+		for (const TWeakObjectPtr<ALedge>& Other : Ledges)
+		{
+			if(Other.IsValid())
+			{
+				UE_LOG(LogAdventureMovement, Warning, TEXT("%s: ledge id %08x collides with %s, neither can be sent over the network"),
+					*Ledge->GetPathName(), LedgeId, *Other->GetPathName());
+			}
+		}
+		Ledges.Add(Ledge);
+	}
+	Ledge->LedgeId = LedgeId;
+
+	const TObjectKey<ULevel> Level(Ledge->GetLevel());
+	LedgeEntries.Add(Ledge, { Level, Snapshot.Serial, LedgeId });
+
+	if(ShouldBuildAsync(Ledge))
+	{
+		QueuedSnapshots.FindOrAdd(Level).Add(MoveTemp(Snapshot));
+		return;
+	}
+
+	FPartition Built;
+	Built.Add(Snapshot);
+	MergePartition(Level, MoveTemp(Built));
+}
+
+void ULedgeRegistry::UnregisterLedge(ALedge* Ledge)
+{
+	FLedgeEntry Entry;
+	if(!LedgeEntries.RemoveAndCopyValue(Ledge, Entry))
+	{
+		return;
+	}
+
+	RemoveLedgeId(Entry.LedgeId, Ledge);
+	Ledge->LedgeId = 0;
+
+	if(TArray<FLedgeSnapshot>* Snapshots = QueuedSnapshots.Find(Entry.Level))
+	{
+		Snapshots->RemoveAllSwap([Ledge](const FLedgeSnapshot& Snapshot) { return Snapshot.Ledge.Get() == Ledge; });
+	}
+
+	// A ledge whose build is still running is dropped when the build merges
+	FPartition* Partition = Partitions.Find(Entry.Level);
+	FRegisteredLedge Old;
+	if(Partition != nullptr && Partition->Ledges.RemoveAndCopyValue(Ledge, Old))
+	{
+		Partition->RemoveFromGrid(Ledge, Old);
+		if(Partition->Ledges.Num() == 0)
+		{
+			Partitions.Remove(Entry.Level);
+		}
+		RelinkNeighbours(Old.Ends, {});
+	}
+}
+
+void ULedgeRegistry::GatherLedges(const FBox& Box, FLedgeList& OutLedges) const
+{
+	const FIntVector MinCell = GetCell(Box.Min);
+	const FIntVector MaxCell = GetCell(Box.Max);
+	for (const TPair<TObjectKey<ULevel>, FPartition>& Pair : Partitions)
+	{
+		const FPartition& Partition = Pair.Value;
+		if(!Partition.Bounds.IsValid || !Partition.Bounds.Intersect(Box))
+		{
+			continue;
+		}
+
+		for(int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for(int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for(int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					if(const auto* Cell = Partition.LedgeGrid.Find(FIntVector(X, Y, Z)))
+					{
+						for (const TWeakObjectPtr<ALedge>& WeakLedge : *Cell)
+						{
+							ALedge* Ledge = WeakLedge.Get();
+							if(Ledge != nullptr && !OutLedges.Contains(Ledge) && Ledge->GetGrabBounds().Intersect(Box))
+							{
+								OutLedges.Add(Ledge);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+ALedge* ULedgeRegistry::ResolveLedge(uint32 LedgeId) const
+{
+	const auto* Ledges = LedgeId != 0 ? LedgesById.Find(LedgeId) : nullptr;
+	if(Ledges == nullptr)
+	{
+		return nullptr;
+	}
+
+	ALedge* Resolved = nullptr;
+	for (const TWeakObjectPtr<ALedge>& Ledge : *Ledges)
+	{
+		if(ALedge* Loaded = Ledge.Get())
+		{
+			if(Resolved != nullptr)
+			{
+				return nullptr;
+			}
+			Resolved = Loaded;
+		}
+	}
+	return Resolved;
+}
+
+void ULedgeRegistry::RemoveLedgeId(uint32 LedgeId, const TWeakObjectPtr<ALedge>& Ledge)
+{
+	auto* Ledges = LedgeId != 0 ? LedgesById.Find(LedgeId) : nullptr;
+	if(Ledges != nullptr)
+	{
+		Ledges->RemoveSingleSwap(Ledge);
+		if(Ledges->Num() == 0)
+		{
+			LedgesById.Remove(LedgeId);
+		}
+	}
+}
+
+uint32 ULedgeRegistry::MakeLedgeId(const ALedge* Ledge)
+{
+	if(Ledge == nullptr || !Ledge->IsNameStableForNetworking())
+	{
+		return 0;
+	}
+
+	// Only the PIE prefix of the package differs between machines, the level package itself keeps duplicate level instances apart
+	const uint32 LedgeId = FCrc::StrCrc32(*UWorld::RemovePIEPrefix(Ledge->GetPathName()));
+	return LedgeId != 0 ? LedgeId : 1;
+}
+
+void ULedgeRegistry::ReportPartitions() const
+{
+	SIZE_T TotalBytes = 0;
+	for (const TPair<TObjectKey<ULevel>, FPartition>& Pair : Partitions)
+	{
+		const ULevel* Level = Pair.Key.ResolveObjectPtr();
+		const SIZE_T Bytes = Pair.Value.GetAllocatedSize();
+		TotalBytes += Bytes;
+		UE_LOG(LogAdventureMovement, Log, TEXT("%s: %d ledges, %d end cells, %d ledge cells, %.1f KB"),
+			Level != nullptr ? *Level->GetOuter()->GetName() : TEXT("<unloaded>"), Pair.Value.Ledges.Num(),
+			Pair.Value.EndGrid.Num(), Pair.Value.LedgeGrid.Num(), Bytes / 1024.f);
+	}
+
+	UE_LOG(LogAdventureMovement, Log, TEXT("Ledge partitions: %d, ledges: %d, building: %d, total %.1f KB"),
+		Partitions.Num(), LedgeEntries.Num(), Builds.Num(), TotalBytes / 1024.f);
+}
+
+FIntVector ULedgeRegistry::GetCell(const FVector& Location)
+{
+	return FIntVector(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize), FMath::FloorToInt32(Location.Z / CellSize));
+}
+
+TArray<ULedgeRegistry::FFaceEnd> ULedgeRegistry::GetEnds(ALedge* Ledge) const
+{
+	TArray<FFaceEnd> Ends;
+	const TArray<FLedgeFace>& Faces = Ledge->GetFaces();
+	Ends.Reserve(Faces.Num() * 2);
+	for(int32 FaceIndex = 0; FaceIndex < Faces.Num(); FaceIndex++)
+	{
+		const FLedgeFace& Face = Faces[FaceIndex];
+		Ends.Add({ Ledge, FaceIndex, FLedgeFace::LeftEnd, Ledge->GetGrabPoint(Face.LeftPoint).Location });
+		Ends.Add({ Ledge, FaceIndex, FLedgeFace::RightEnd, Ledge->GetGrabPoint(Face.RightPoint).Location });
+	}
+
+	return Ends;
+}
+
+bool ULedgeRegistry::ShouldBuildAsync(const ALedge* Ledge) const
+{
+	// Runtime edits refresh inline, a ledge must not vanish from the grids while it is being edited
+	const ULevel* Level = Ledge->GetLevel();
+	return CVarLedgeAsyncPartitionBuild.GetValueOnGameThread() && Ledge->IsActorBeginningPlay()
+		&& Level != nullptr && !Level->IsPersistentLevel();
+}
+
+void ULedgeRegistry::MergePartition(const TObjectKey<ULevel>& Level, FPartition&& Built)
+{
+	TArray<TWeakObjectPtr<ALedge>, TInlineAllocator<16>> Stale;
+	for (const TPair<TWeakObjectPtr<ALedge>, FRegisteredLedge>& Pair : Built.Ledges)
+	{
+		const FLedgeEntry* Entry = LedgeEntries.Find(Pair.Key);
+		if(Entry == nullptr || Entry->Serial != Pair.Value.Serial)
+		{
+			Stale.Add(Pair.Key);
+		}
+	}
+
+	for (const TWeakObjectPtr<ALedge>& Ledge : Stale)
+	{
+		FRegisteredLedge Entry;
+		Built.Ledges.RemoveAndCopyValue(Ledge, Entry);
+		Built.RemoveFromGrid(Ledge, Entry);
+	}
+
+	if(Built.Ledges.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FFaceEnd> NewEnds;
+	TSet<const ALedge*> NewLedges;
+	for (const TPair<TWeakObjectPtr<ALedge>, FRegisteredLedge>& Pair : Built.Ledges)
+	{
+		NewEnds.Append(Pair.Value.Ends);
+		NewLedges.Add(Pair.Key.Get());
+	}
+
+	Partitions.FindOrAdd(Level).Append(MoveTemp(Built));
+
+	// The new ends see each other and their neighbours, the neighbours only have to pick up the new ends
+	for (const FFaceEnd& End : NewEnds)
+	{
+		LinkEnd(End);
+	}
+	RelinkNeighbours(NewEnds, NewLedges);
+}
+
+void ULedgeRegistry::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if(Level == nullptr || World != GetWorld())
+	{
+		return;
+	}
+
+	// Ledges of a streamed out level skip their own unregister, the partition goes as a whole
+	const TObjectKey<ULevel> Key(Level);
+	QueuedSnapshots.Remove(Key);
+	for (auto It = LedgeEntries.CreateIterator(); It; ++It)
+	{
+		if(It->Value.Level == Key)
+		{
+			RemoveLedgeId(It->Value.LedgeId, It->Key);
+			It.RemoveCurrent();
+		}
+	}
+
+	FPartition Removed;
+	if(Partitions.RemoveAndCopyValue(Key, Removed))
+	{
+		TArray<FFaceEnd> Ends;
+		for (const TPair<TWeakObjectPtr<ALedge>, FRegisteredLedge>& Pair : Removed.Ledges)
+		{
+			Ends.Append(Pair.Value.Ends);
+		}
+		RelinkNeighbours(Ends, {});
+	}
+}
+
+void ULedgeRegistry::FPartition::Add(const FLedgeSnapshot& Snapshot)
+{
+	FRegisteredLedge Entry;
+	Entry.Ends = Snapshot.Ends;
+	Entry.Serial = Snapshot.Serial;
+	for (const FFaceEnd& End : Entry.Ends)
+	{
+		EndGrid.FindOrAdd(GetCell(End.Location)).Add(End);
+		Bounds += End.Location;
+	}
+
+	if(Snapshot.Bounds.IsValid)
+	{
+		Entry.MinCell = GetCell(Snapshot.Bounds.Min);
+		Entry.MaxCell = GetCell(Snapshot.Bounds.Max);
+		for(int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+		{
+			for(int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+			{
+				for(int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+				{
+					LedgeGrid.FindOrAdd(FIntVector(X, Y, Z)).Add(Snapshot.Ledge);
+				}
+			}
+		}
+		Bounds += Snapshot.Bounds;
+	}
+
+	Ledges.Add(Snapshot.Ledge, MoveTemp(Entry));
+}
+
+void ULedgeRegistry::FPartition::Append(FPartition&& Other)
+{
+	if(Ledges.Num() == 0)
+	{
+		*this = MoveTemp(Other);
+		return;
+	}
+
+	for (TPair<FIntVector, TArray<FFaceEnd>>& Pair : Other.EndGrid)
+	{
+		EndGrid.FindOrAdd(Pair.Key).Append(MoveTemp(Pair.Value));
+	}
+
+	for (auto& Pair : Other.LedgeGrid)
+	{
+		LedgeGrid.FindOrAdd(Pair.Key).Append(MoveTemp(Pair.Value));
+	}
+
+	Ledges.Append(MoveTemp(Other.Ledges));
+	Bounds += Other.Bounds;
+}
+
+void ULedgeRegistry::FPartition::RemoveFromGrid(const TWeakObjectPtr<ALedge>& Ledge, const FRegisteredLedge& Entry)
+{
+	for (const FFaceEnd& End : Entry.Ends)
+	{
+		const FIntVector Cell = GetCell(End.Location);
+		if(TArray<FFaceEnd>* CellEnds = EndGrid.Find(Cell))
+		{
+			CellEnds->RemoveAllSwap([&End](const FFaceEnd& Other) { return Other.Ledge == End.Ledge && Other.Face == End.Face && Other.End == End.End; });
+			if(CellEnds->Num() == 0)
+			{
+				EndGrid.Remove(Cell);
+			}
+		}
+	}
+
+	for(int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for(int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for(int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				const FIntVector Cell(X, Y, Z);
+				if(auto* CellLedges = LedgeGrid.Find(Cell))
+				{
+					CellLedges->RemoveAllSwap([&Ledge](const TWeakObjectPtr<ALedge>& Other) { return Other == Ledge || !Other.IsValid(); });
+					if(CellLedges->Num() == 0)
+					{
+						LedgeGrid.Remove(Cell);
+					}
+				}
+			}
+		}
+	}
+}
+
+SIZE_T ULedgeRegistry::FPartition::GetAllocatedSize() const
+{
+	SIZE_T Bytes = Ledges.GetAllocatedSize() + EndGrid.GetAllocatedSize() + LedgeGrid.GetAllocatedSize();
+	for (const TPair<TWeakObjectPtr<ALedge>, FRegisteredLedge>& Pair : Ledges)
+	{
+		Bytes += Pair.Value.Ends.GetAllocatedSize();
+	}
+	for (const TPair<FIntVector, TArray<FFaceEnd>>& Pair : EndGrid)
+	{
+		Bytes += Pair.Value.GetAllocatedSize();
+	}
+	for (const auto& Pair : LedgeGrid)
+	{
+		Bytes += Pair.Value.GetAllocatedSize();
+	}
+
+	return Bytes;
+}
+
+void ULedgeRegistry::GatherNearbyEnds(const FVector& Location, TArray<FFaceEnd>& OutEnds) const
+{
+	// CornerLinkDistance is below the cell size, so the neighbouring cells cover the search radius
+	const FIntVector Center = GetCell(Location);
+	for (const TPair<TObjectKey<ULevel>, FPartition>& Pair : Partitions)
+	{
+		const FPartition& Partition = Pair.Value;
+		if(!Partition.Bounds.IsValid || Partition.Bounds.ComputeSquaredDistanceToPoint(Location) > FMath::Square(CornerLinkDistance))
+		{
+			continue;
+		}
+
+		for(int32 X = -1; X <= 1; X++)
+		{
+			for(int32 Y = -1; Y <= 1; Y++)
+			{
+				for(int32 Z = -1; Z <= 1; Z++)
+				{
+					if(const TArray<FFaceEnd>* Cell = Partition.EndGrid.Find(Center + FIntVector(X, Y, Z)))
+					{
+						for (const FFaceEnd& End : *Cell)
+						{
+							if(FVector::DistSquared(End.Location, Location) <= FMath::Square(CornerLinkDistance))
+							{
+								OutEnds.Add(End);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void ULedgeRegistry::LinkEnd(const FFaceEnd& End)
+{
+	using namespace LedgeRegistry;
+
+	ALedge* Ledge = End.Ledge.Get();
+	if(Ledge == nullptr || !Ledge->Faces.IsValidIndex(End.Face))
+	{
+		return;
+	}
+
+	FLedgeFace& Face = Ledge->Faces[End.Face];
+	FLedgeCorner& Corner = Face.Corners[End.End];
+	Corner = FLedgeCorner();
+
+	// Direction a character on this face shimmies in to reach this end
+	const FVector Normal = Ledge->GetGrabPoint(End.End == FLedgeFace::RightEnd ? Face.RightPoint : Face.LeftPoint).Normal;
+	const FVector Right = FVector::CrossProduct(FVector::UpVector, -Normal).GetSafeNormal2D();
+	const FVector Direction = End.End == FLedgeFace::RightEnd ? Right : -Right;
+
+	TArray<FFaceEnd> Candidates;
+	GatherNearbyEnds(End.Location, Candidates);
+
+	float BestDistance = TNumericLimits<float>::Max();
+	for (const FFaceEnd& Candidate : Candidates)
+	{
+		ALedge* CandidateLedge = Candidate.Ledge.Get();
+		if(CandidateLedge == nullptr || (CandidateLedge == Ledge && Candidate.Face == End.Face)
+			|| FMath::Abs(Candidate.Location.Z - End.Location.Z) > MaxCornerHeightDelta)
+		{
+			continue;
+		}
+
+		const FLedgeFace& CandidateFace = CandidateLedge->Faces[Candidate.Face];
+		const FLedgeGrabPoint Target = CandidateLedge->GetGrabPoint(Candidate.End == FLedgeFace::RightEnd ? CandidateFace.RightPoint : CandidateFace.LeftPoint);
+		const float Alignment = FVector::DotProduct(Target.Normal.GetSafeNormal2D(), Direction);
+
+		// Out: the next face looks along the shimmy direction. In: it faces back against it.
+		const ELedgeCornerType Type = Alignment > CornerNormalAlignment ? ELedgeCornerType::Out
+			: Alignment < -CornerNormalAlignment ? ELedgeCornerType::In : ELedgeCornerType::None;
+		const float Distance = FVector::DistSquared(Candidate.Location, End.Location);
+		if(Type != ELedgeCornerType::None && Distance < BestDistance)
+		{
+			BestDistance = Distance;
+			Corner.AdjacentLedge = CandidateLedge;
+			Corner.AdjacentFace = Candidate.Face;
+			Corner.Type = Type;
+			Corner.Target = Target;
+			Corner.TargetRotation = FRotationMatrix::MakeFromZX(FVector::UpVector, -Target.Normal.GetSafeNormal2D()).Rotator();
+		}
+	}
+}
+
+void ULedgeRegistry::RelinkNeighbours(const TArray<FFaceEnd>& Ends, const TSet<const ALedge*>& Except)
+{
+	TArray<FFaceEnd> Neighbours;
+	for (const FFaceEnd& End : Ends)
+	{
+		GatherNearbyEnds(End.Location, Neighbours);
+	}
+
+	for (const FFaceEnd& Neighbour : Neighbours)
+	{
+		if(!Except.Contains(Neighbour.Ledge.Get()))
+		{
+			LinkEnd(Neighbour);
+		}
+	}
+}
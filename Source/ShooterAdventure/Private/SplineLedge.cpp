@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SplineLedge.h"
+
+#include "Algo/BinarySearch.h"
+#include "Components/SplineComponent.h"
+
+ASplineLedge::ASplineLedge()
+{
+	Edge = CreateDefaultSubobject<USplineComponent>(TEXT("Edge"));
+	Edge->SetupAttachment(RootComponent);
+}
+
+void ASplineLedge::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	RebuildEdge();
+}
+
+void ASplineLedge::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	RebuildEdge();
+}
+
+void ASplineLedge::RebuildEdge()
+{
+	Samples.Reset();
+	SampleNormals.Reset();
+	ArcLengths.Reset();
+	Nodes.Reset();
+	CornerDistances.Reset();
+	CornerInside.Reset();
+
+	const float SplineLength = Edge->GetSplineLength();
+	if(SplineLength <= UE_KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	bClosedLoop = Edge->IsClosedLoop();
+	const FTransform WorldToActor = GetActorTransform().Inverse();
+	const float Side = bWallFacesRight ? 1.f : -1.f;
+	const int32 NumSegments = FMath::Max(FMath::CeilToInt32(SplineLength / FMath::Max(SampleSpacing, 1.f)), 1);
+
+	Samples.Reserve(NumSegments + 1);
+	SampleNormals.Reserve(NumSegments + 1);
+	ArcLengths.Reserve(NumSegments + 1);
+	for(int32 Index = 0; Index <= NumSegments; Index++)
+	{
+		const float Distance = SplineLength * Index / NumSegments;
+		const FVector Location = WorldToActor.TransformPosition(Edge->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World));
+		const FVector Tangent = WorldToActor.TransformVectorNoScale(Edge->GetDirectionAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World)).GetSafeNormal2D();
+
+		Samples.Add(FVector3f(Location));
+		SampleNormals.Add(FVector3f(FVector::CrossProduct(FVector::UpVector, Tangent) * Side));
+
+		// Polyline length rather than spline length so the table agrees with the segments
+		ArcLengths.Add(Index == 0 ? 0.f : ArcLengths.Last() + FVector3f::Dist(Samples[Index - 1], Samples[Index]));
+	}
+
+	const float CornerCos = FMath::Cos(FMath::DegreesToRadians(CornerAngle));
+	const int32 LastSample = Samples.Num() - 1;
+	for(int32 Index = bClosedLoop ? 0 : 1; Index < LastSample; Index++)
+	{
+		// On closed loops the last sample sits on the first one
+		const int32 Previous = Index == 0 ? LastSample - 1 : Index - 1;
+		const FVector3f In = (Samples[Index] - Samples[Previous]).GetSafeNormal2D();
+		const FVector3f Out = (Samples[Index + 1] - Samples[Index]).GetSafeNormal2D();
+		if((In | Out) < CornerCos)
+		{
+			const FVector3f InNormal = FVector3f::CrossProduct(FVector3f::UpVector, In) * Side;
+			CornerDistances.Add(ArcLengths[Index]);
+			CornerInside.Add((Out | InNormal) > 0.f);
+		}
+	}
+
+	Nodes.Reserve(2 * NumSegments / SegmentsPerLeaf + 1);
+	BuildNode(0, NumSegments);
+}
+
+int32 ASplineLedge::BuildNode(int32 FirstSegment, int32 NumSegments)
+{
+	FBox3f Bounds(ForceInit);
+	for(int32 Index = FirstSegment; Index <= FirstSegment + NumSegments; Index++)
+	{
+		Bounds += Samples[Index];
+	}
+
+	const int32 NodeIndex = Nodes.AddUninitialized();
+	if(NumSegments <= SegmentsPerLeaf)
+	{
+		Nodes[NodeIndex] = { Bounds, FirstSegment, NumSegments, true };
+		return NodeIndex;
+	}
+
+	// Samples are already ordered along the edge, splitting the range in half keeps the tree balanced
+	const int32 Half = NumSegments / 2;
+	const int32 Left = BuildNode(FirstSegment, Half);
+	const int32 Right = BuildNode(FirstSegment + Half, NumSegments - Half);
+	Nodes[NodeIndex] = { Bounds, Left, Right, false };
+	return NodeIndex;
+}
+
+float ASplineLedge::NormalizeDistance(float Distance) const
+{
+	const float Length = GetEdgeLength();
+	if(bClosedLoop && Length > 0.f)
+	{
+		Distance = FMath::Fmod(Distance, Length);
+		return Distance < 0.f ? Distance + Length : Distance;
+	}
+
+	return FMath::Clamp(Distance, 0.f, Length);
+}
+
+bool ASplineLedge::IsDistanceOnEdge(float Distance) const
+{
+	return bClosedLoop || (Distance >= 0.f && Distance <= GetEdgeLength());
+}
+
+int32 ASplineLedge::FindSegmentAtDistance(float Distance) const
+{
+	const int32 Index = Algo::UpperBound(ArcLengths, Distance) - 1;
+	return FMath::Clamp(Index, 0, ArcLengths.Num() - 2);
+}
+
+FLedgeGrabPoint ASplineLedge::MakeEdgePoint(int32 Segment, float Alpha) const
+{
+	const FTransform& ActorTransform = GetActorTransform();
+
+	FLedgeGrabPoint Point;
+	Point.Location = ActorTransform.TransformPosition(FVector(FMath::Lerp(Samples[Segment], Samples[Segment + 1], Alpha)));
+	Point.Normal = ActorTransform.TransformVectorNoScale(FVector(FMath::Lerp(SampleNormals[Segment], SampleNormals[Segment + 1], Alpha).GetSafeNormal()));
+	Point.Index = Segment;
+	return Point;
+}
+
+FLedgeGrabPoint ASplineLedge::GetEdgePointAtDistance(float Distance) const
+{
+	if(Samples.Num() < 2)
+	{
+		return FLedgeGrabPoint();
+	}
+
+	Distance = NormalizeDistance(Distance);
+	const int32 Segment = FindSegmentAtDistance(Distance);
+	const float SegmentLength = ArcLengths[Segment + 1] - ArcLengths[Segment];
+	return MakeEdgePoint(Segment, FMath::Clamp((Distance - ArcLengths[Segment]) / FMath::Max(SegmentLength, UE_SMALL_NUMBER), 0.f, 1.f));
+}
+
+FVector ASplineLedge::GetEdgeTangentAtDistance(float Distance) const
+{
+	if(Samples.Num() < 2)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const int32 Segment = FindSegmentAtDistance(NormalizeDistance(Distance));
+	return GetActorTransform().TransformVectorNoScale(FVector(Samples[Segment + 1] - Samples[Segment]).GetSafeNormal());
+}
+
+bool ASplineLedge::FindClosestEdgePoint(const FVector& WorldLocation, FLedgeGrabPoint& OutPoint, float& OutDistance) const
+{
+	if(Nodes.Num() == 0)
+	{
+		return false;
+	}
+
+	const FVector3f Point(GetActorTransform().InverseTransformPosition(WorldLocation));
+	float BestDistanceSquared = TNumericLimits<float>::Max();
+	int32 BestSegment = INDEX_NONE;
+	float BestAlpha = 0.f;
+
+	TArray<int32, TInlineAllocator<32>> Stack;
+	Stack.Add(0);
+	while(Stack.Num() > 0)
+	{
+		const FEdgeNode& Node = Nodes[Stack.Pop(false)];
+		if(Node.Bounds.ComputeSquaredDistanceToPoint(Point) >= BestDistanceSquared)
+		{
+			continue;
+		}
+
+		if(Node.bLeaf)
+		{
+			for(int32 Segment = Node.First; Segment < Node.First + Node.Second; Segment++)
+			{
+				const FVector3f Start = Samples[Segment];
+				const FVector3f Direction = Samples[Segment + 1] - Start;
+				const float Alpha = FMath::Clamp(((Point - Start) | Direction) / FMath::Max(Direction.SizeSquared(), UE_SMALL_NUMBER), 0.f, 1.f);
+				const float DistanceSquared = FVector3f::DistSquared(Point, Start + Direction * Alpha);
+				if(DistanceSquared < BestDistanceSquared)
+				{
+					BestDistanceSquared = DistanceSquared;
+					BestSegment = Segment;
+					BestAlpha = Alpha;
+				}
+			}
+		}
+		else
+		{
+			// Push the nearer child last so it is visited first and prunes the other one
+			const bool bLeftFirst = Nodes[Node.First].Bounds.ComputeSquaredDistanceToPoint(Point) <= Nodes[Node.Second].Bounds.ComputeSquaredDistanceToPoint(Point);
+			Stack.Add(bLeftFirst ? Node.Second : Node.First);
+			Stack.Add(bLeftFirst ? Node.First : Node.Second);
+		}
+	}
+
+	OutPoint = MakeEdgePoint(BestSegment, BestAlpha);
+	OutDistance = FMath::Lerp(ArcLengths[BestSegment], ArcLengths[BestSegment + 1], BestAlpha);
+	return true;
+}
+
+bool ASplineLedge::GetClosestGrabPoint(FVector Origin, FLedgeGrabPoint& OutPoint) const
+{
+	float Distance;
+	return FindClosestEdgePoint(Origin, OutPoint, Distance);
+}
+
+FBox ASplineLedge::GetGrabBounds() const
+{
+	if(Nodes.Num() == 0)
+	{
+		return FBox(ForceInit);
+	}
+
+	// The root of the segment BVH already bounds the whole edge
+	return FBox(FVector(Nodes[0].Bounds.Min), FVector(Nodes[0].Bounds.Max)).TransformBy(GetActorTransform());
+}
+
+bool ASplineLedge::FindCorner(float Distance, float Direction, float Range, float& OutCornerDistance, bool& bOutInside) const
+{
+	const int32 NumCorners = CornerDistances.Num();
+	if(NumCorners == 0)
+	{
+		return false;
+	}
+
+	// Closed loops see the corners across the seam, shifted by one edge length
+	int32 Index;
+	float Wrap = 0.f;
+	if(Direction > 0.f)
+	{
+		Index = Algo::UpperBound(CornerDistances, Distance);
+		if(Index == NumCorners)
+		{
+			Index = 0;
+			Wrap = GetEdgeLength();
+		}
+	}
+	else
+	{
+		Index = Algo::LowerBound(CornerDistances, Distance) - 1;
+		if(Index < 0)
+		{
+			Index = NumCorners - 1;
+			Wrap = -GetEdgeLength();
+		}
+	}
+
+	if(Wrap != 0.f && !bClosedLoop)
+	{
+		return false;
+	}
+
+	const float Corner = CornerDistances[Index] + Wrap;
+
+	if(FMath::Abs(Corner - Distance) > Range)
+	{
+		return false;
+	}
+
+	OutCornerDistance = NormalizeDistance(Corner);
+	bOutInside = CornerInside[Index];
+	return true;
+}
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterAdventureCharacter.h"
+#include "AdventureBotCharacter.generated.h"
+
+/**
+ * Lean character for AI and server side bots. Shares movement, climbing and abilities with the player character
+ * but never creates the camera rig and ignores player input, so hundreds can run without the per-frame camera cost.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API AAdventureBotCharacter : public AShooterAdventureCharacter
+{
+	GENERATED_BODY()
+
+public:
+	AAdventureBotCharacter(const FObjectInitializer& ObjectInitializer);
+
+protected:
+	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
+};
@@ -6,6 +6,8 @@
 #include "Camera/PlayerCameraManager.h"
 #include "AdventureCameraManager.generated.h"
 
+class AShooterAdventureCharacter;
+
 /**
  * 
  */
@@ -17,9 +19,34 @@ class SHOOTERADVENTURE_API AAdventureCameraManager : public APlayerCameraManager
 	UPROPERTY(EditDefaultsOnly) float CrouchBlendDuration = 0.5f;
 
 	float CrouchBlendTime;
+
+	/** Replaces the camera boom's synchronous collision test with an async sweep issued one frame ahead */
+	UPROPERTY(EditDefaultsOnly, Category=Occlusion) bool bAsyncOcclusion = true;
+
+	/** How fast the camera moves back out once unoccluded, pulling in is immediate */
+	UPROPERTY(EditDefaultsOnly, Category=Occlusion) float OcclusionRecoverSpeed = 10.f;
 	
 public:
 	AAdventureCameraManager();
 
 	virtual void UpdateViewTarget(FTViewTarget& OutVT, float DeltaTime) override;
+
+private:
+	/** Pawn the cached character and occlusion state belong to */
+	TWeakObjectPtr<APawn> CachedPawn;
+	TWeakObjectPtr<AShooterAdventureCharacter> CachedCharacter;
+
+	/** Crouched minus standing capsule half height of CachedCrouchClass's defaults */
+	TWeakObjectPtr<UClass> CachedCrouchClass;
+	float CachedCrouchOffsetZ = 0.f;
+
+	FTraceHandle OcclusionTraceHandle;
+	/** Fraction of the arm left clear of occluders, smoothed over time */
+	float OcclusionFraction = 1.f;
+	float TargetOcclusionFraction = 1.f;
+
+	AShooterAdventureCharacter* GetViewCharacter();
+	float GetCrouchOffsetZ(const AShooterAdventureCharacter* Character);
+	void SetBoomCollision(AShooterAdventureCharacter* Character, bool bEnabled) const;
+	void UpdateOcclusion(const AShooterAdventureCharacter* Character, FTViewTarget& OutVT, float DeltaTime);
 };
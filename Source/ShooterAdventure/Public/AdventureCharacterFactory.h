@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "AdventureCharacterFactory.generated.h"
+
+class AController;
+
+UENUM(BlueprintType)
+enum class EAdventureCharacterArchetype : uint8
+{
+	/** Full character with camera rig and input bindings */
+	Player,
+	/** Camera-less character driven by an AI controller */
+	Bot
+};
+
+/** Picks between the player and bot character variants and spawns them */
+UCLASS()
+class SHOOTERADVENTURE_API UAdventureCharacterFactory : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/** Player controllers get the full character, everything else the bot */
+	UFUNCTION(BlueprintPure, Category=Characters)
+	static EAdventureCharacterArchetype GetArchetypeFor(const AController* Controller);
+
+	/** Class configured on the game mode for the archetype, null when it is missing */
+	UFUNCTION(BlueprintPure, Category=Characters, meta=(WorldContext="WorldContextObject"))
+	static TSubclassOf<APawn> GetCharacterClass(const UObject* WorldContextObject, EAdventureCharacterArchetype Archetype);
+
+	/** Spawns the archetype's class, bots come back possessed by their default AI controller */
+	UFUNCTION(BlueprintCallable, Category=Characters, meta=(WorldContext="WorldContextObject"))
+	static APawn* SpawnCharacter(const UObject* WorldContextObject, EAdventureCharacterArchetype Archetype, const FTransform& Transform);
+};
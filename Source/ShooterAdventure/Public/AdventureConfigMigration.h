@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EDITORONLY_DATA
+/**
+ * Carries the _DEPRECATED properties of Owner over into a new ConfigType outered to Owner, matched by name without the suffix.
+ * Returns null when every deprecated value still matches the ConfigType class defaults, nothing was tuned then.
+ */
+template<typename ConfigType>
+ConfigType* MigrateDeprecatedConfig(UObject* Owner)
+{
+	static const FString DeprecatedSuffix(TEXT("_DEPRECATED"));
+
+	const ConfigType* Defaults = GetDefault<ConfigType>();
+	ConfigType* Migrated = nullptr;
+	for (TFieldIterator<FProperty> It(Owner->GetClass()); It; ++It)
+	{
+		const FString Name = It->GetName();
+		if(!It->HasAnyPropertyFlags(CPF_Deprecated) || !Name.EndsWith(DeprecatedSuffix))
+		{
+			continue;
+		}
+
+		const FProperty* ConfigProperty = FindFProperty<FProperty>(ConfigType::StaticClass(), *Name.LeftChop(DeprecatedSuffix.Len()));
+		const void* OldValue = It->ContainerPtrToValuePtr<void>(Owner);
+		if(ConfigProperty == nullptr || !ConfigProperty->SameType(*It) || ConfigProperty->Identical(OldValue, ConfigProperty->ContainerPtrToValuePtr<void>(Defaults)))
+		{
+			continue;
+		}
+
+		if(Migrated == nullptr)
+		{
+			Migrated = NewObject<ConfigType>(Owner, ConfigType::StaticClass(), MakeUniqueObjectName(Owner, ConfigType::StaticClass(), TEXT("MigratedConfig")), Owner->GetMaskedFlags(RF_PropagateToSubObjects));
+		}
+		ConfigProperty->CopyCompleteValue(ConfigProperty->ContainerPtrToValuePtr<void>(Migrated), OldValue);
+	}
+	return Migrated;
+}
+#endif
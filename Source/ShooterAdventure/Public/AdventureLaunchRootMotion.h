@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/RootMotionSource.h"
+#include "AdventureLaunchRootMotion.generated.h"
+
+/**
+ * Ballistic climb launch from StartLocation to TargetLocation over Duration under GravityZ.
+ * Every tick moves with the arc's average velocity over that tick, which is exact for a parabola, so the path doesn't
+ * depend on frame rate. It never aims at the absolute arc, a blocking hit stops the character instead of being caught up later.
+ */
+USTRUCT()
+struct SHOOTERADVENTURE_API FRootMotionSource_AdventureLaunch : public FRootMotionSource
+{
+	GENERATED_USTRUCT_BODY()
+
+	FRootMotionSource_AdventureLaunch();
+
+	UPROPERTY() FVector StartLocation = FVector::ZeroVector;
+	UPROPERTY() FVector TargetLocation = FVector::ZeroVector;
+	UPROPERTY() float GravityZ = 0.f;
+
+	/** Sets start, target and duration from a launch velocity */
+	void SetArc(const FVector& Start, const FVector& LaunchVelocity, float InGravityZ, float InDuration);
+
+	FVector GetVelocityAtTime(float Time) const;
+
+	virtual FRootMotionSource* Clone() const override;
+	virtual bool Matches(const FRootMotionSource* Other) const override;
+	virtual void PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent) override;
+	virtual bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToSimpleString() const override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRootMotionSource_AdventureLaunch> : public TStructOpsTypeTraitsBase2<FRootMotionSource_AdventureLaunch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true
+	};
+};
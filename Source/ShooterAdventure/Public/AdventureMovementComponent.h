@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "AdventureMovementHistory.h"
+#include "AdventureMovementConfig.h"
+#include <atomic>
 #include "AdventureMovementComponent.generated.h"
 
 class UClimbingComponent;
@@ -19,6 +22,15 @@ enum ECustomMovementMode
 	CMOVE_Max		UMETA(Hidden),
 };
 
+/** Client prediction corrections for one movement mode, or one transition when client and server modes disagree */
+struct FAdventureCorrectionStats
+{
+	int32 Corrections = 0;
+	int32 ResimulatedMoves = 0;
+	float TotalDistance = 0.f;
+	float MaxDistance = 0.f;
+};
+
 /**
  * 
  */
@@ -38,36 +50,137 @@ class SHOOTERADVENTURE_API UAdventureMovementComponent : public UCharacterMoveme
 			FLAG_Custom_3		= 0x80,			
 		};
 		
+		// Simulation clock, restored on replay so tick timers don't advance twice
+		float Saved_SimTimeAccumulator;
+		float Saved_StepTimeAccumulator;
+		int32 Saved_RollTicksLeft;
+		int32 Saved_RollCooldownTicksLeft;
+		int32 Saved_ClimbingTimerTicksLeft;
+		uint16 Saved_ClimbingTimerSerial;
+
 		//Flag
 		uint8 Saved_bWantsToSprint : 1;
 
 		// Not flag
 		uint8 Saved_bPreviousWantstoCrouch:1;
 		uint8 Saved_bWantstoRoll:1;
+
+		// Ledge the character hangs from, as a registry id instead of an actor reference
+		uint32 Saved_LedgeId;
+
+		// Climb launch started by this move
+		FVector Saved_LaunchVelocity;
+		float Saved_LaunchDuration;
 		
 		virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+		virtual bool IsImportantMove(const FSavedMovePtr& LastAckedMove) const override;
 		virtual void Clear() override;
 		virtual uint8 GetCompressedFlags() const override; 
 		virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
 		virtual void PrepMoveFor(ACharacter* C) override;
 	};
 
+public:
+	struct FSavedMovePoolStats
+	{
+		int32 Capacity = 0;
+		int32 InUse = 0;
+		int32 HighWaterMark = 0;
+		int32 FallbackAllocations = 0;
+	};
+
+private:
+	/**
+	 * Saved moves are recycled through the base class free list, which is sized to every move that can be in flight
+	 * and filled up front, so no move is allocated while playing unless the capacity is too small.
+	 */
 	class FNetworkPredictionData_Client_Adventure : public FNetworkPredictionData_Client_Character
 	{
 	public:
-		FNetworkPredictionData_Client_Adventure(const UCharacterMovementComponent& ClientMovement);
+		FNetworkPredictionData_Client_Adventure(const UCharacterMovementComponent& ClientMovement, int32 FreeMoveCapacity);
 
 		typedef FNetworkPredictionData_Client_Character Super;
 
 		virtual FSavedMovePtr AllocateNewMove() override;
+		virtual FSavedMovePtr CreateSavedMove() override;
+		virtual void FreeMove(const FSavedMovePtr& Move) override;
+
+		FSavedMovePoolStats GetPoolStats() const;
+
+	private:
+		int32 NumMoves = 0;
+		int32 HighWaterMark = 0;
+		int32 FallbackAllocations = 0;
+		bool bPrewarming = false;
 	};
+
+	/** Adds the ledge id and climb launches to the packed move RPCs, one bit each while unused */
+	class FAdventureNetworkMoveData : public FCharacterNetworkMoveData
+	{
+	public:
+		typedef FCharacterNetworkMoveData Super;
+
+		uint32 LedgeId = 0;
+		FVector_NetQuantize10 LaunchVelocity;
+		float LaunchDuration = 0.f;
+
+		virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+		virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+	};
+
+	class FAdventureNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+	{
+	public:
+		FAdventureNetworkMoveDataContainer();
+
+		FAdventureNetworkMoveData MoveData[3];
+	};
+
+private:
+	FAdventureNetworkMoveDataContainer AdventureMoveDataContainer;
 #pragma endregion
 	
 	// Network and Saved Move Methods
 protected:
 	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 public:
 	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	bool GetSavedMovePoolStats(FSavedMovePoolStats& OutStats) const;
+
+	/** Counts allocations and times a sustained 240 Hz move stream with and without the free list, results go to the log */
+	static void RunSavedMovePoolBenchmark(int32 PoolCapacity, int32 NumMoves);
+
+	/** Keyed by GetMovementModeLabel, or "Client>Server" labels for corrections across a mode transition */
+	const TMap<FName, FAdventureCorrectionStats>& GetCorrectionStats() const { return CorrectionStats; }
+	void ResetCorrectionStats() { CorrectionStats.Reset(); }
+
+	static FName GetMovementModeLabel(uint8 InMovementMode, uint8 InCustomMode);
+
+protected:
+	virtual void OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+
+private:
+	/** Free saved moves allocated up front, MaxSavedMoveCount in flight plus the pending and acked moves */
+	UPROPERTY(EditDefaultsOnly, Category=Network, meta=(ClampMin=0)) int32 SavedMovePoolCapacity = 100;
+
+	TMap<FName, FAdventureCorrectionStats> CorrectionStats;
+
+	/** Last ledge id the owning client claimed that passed validation */
+	uint32 ClientClaimedLedgeId = 0;
+	/** Last rejected claim, so a client repeating it on every move only gets logged once */
+	uint32 RejectedLedgeId = 0;
+	/** Set by a rejected launch until one is accepted, so a client retrying it only gets logged once */
+	bool bLoggedRejectedLaunch = false;
+
+	/** Server side, checks a new ledge claim against the movement history at the move's time stamp before it is replicated */
+	void UpdateClientLedge(uint32 LedgeId, float ClientTimeStamp);
+	/**
+	 * Server side, a client launch is only taken while hanging and no faster than the climbing component's jumps.
+	 * Unless it is one of the fixed fallback jumps, its arc has to end in grab reach of a registered ledge.
+	 */
+	bool CanAcceptClientLaunch(const FVector& LaunchVelocity, float LaunchDuration) const;
 	
 private:
 	// Transient
@@ -77,23 +190,42 @@ private:
 	bool Safe_bWantsToSprint;
 	bool Safe_bPreviousWantsToCrouch;
 	bool Safe_bWantsToRoll;	
+	FVector Safe_LaunchVelocity = FVector::ZeroVector;
+	float Safe_LaunchDuration = 0.f;
 
 public:
 	UAdventureMovementComponent();
 	virtual void InitializeComponent() override;
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	
-// SPRINT
+	virtual void OnRegister() override;
+	virtual void PostLoad() override;
+
+	/** Shared sprint, slide and roll tuning, the class defaults of UAdventureMovementConfig are used when none is set */
+	UPROPERTY(EditDefaultsOnly, Category=Config) TObjectPtr<UAdventureMovementConfig> MovementConfig;
+
 private:
-	UPROPERTY(EditDefaultsOnly, Category=Sprint) float MaxSprintSpeed;
+	/** Resolved on register, the class defaults until then, never null */
+	const UAdventureMovementConfig* Config = nullptr;
+
+#if WITH_EDITORONLY_DATA
+	// Moved to UAdventureMovementConfig, PostLoad carries values saved on blueprints over into a config owned by the blueprint
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxSprintSpeed_DEPRECATED = 750.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxSlideSpeed_DEPRECATED = 300.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float Slide_EnterImpulse_DEPRECATED = 500.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float Slide_GravityForce_DEPRECATED = 5000.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float Slide_Friction_DEPRECATED = 1.3f;
+	UPROPERTY(meta=(DeprecatedProperty)) float BrakingDecelerationSliding_DEPRECATED = 500.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float RollTimeDuration_DEPRECATED = 1.3f;
+	UPROPERTY(meta=(DeprecatedProperty)) float RollDelayBetweenRolls_DEPRECATED = 0.25f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxRollSpeed_DEPRECATED = 600.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float BrakingDecelerationRolling_DEPRECATED = 2000.f;
+	UPROPERTY(meta=(DeprecatedProperty)) bool bCanWalkOffLedgeWhenRolling_DEPRECATED = true;
+#endif
 
 // SLIDE
 private:
-	UPROPERTY(EditDefaultsOnly, Category=Slide) float MaxSlideSpeed = 300.f;
-	UPROPERTY(EditDefaultsOnly, Category=Slide) float Slide_EnterImpulse = 500.f;
-	UPROPERTY(EditDefaultsOnly, Category=Slide) float Slide_GravityForce = 5000.f;
-	UPROPERTY(EditDefaultsOnly, Category=Slide) float Slide_Friction = 1.3f;	
-	UPROPERTY(EditDefaultsOnly, Category=Slide) float BrakingDecelerationSliding = 500.f;
-	
 	void EnterSlide();
 	void ExitSlide();
 	void PhysSlide(float deltaTime, int32 Iterations);
@@ -105,27 +237,116 @@ public:
 	void EnterRoll(EMovementMode PreviousMovementMode, ECustomMovementMode PreviousCustomMode);
 
 private:
-	UPROPERTY(EditDefaultsOnly, Category=Roll) float RollTimeDuration = 1.3f;
-	UPROPERTY(EditDefaultsOnly, Category=Roll) float RollDelayBetweenRolls = 0.25f;
-	UPROPERTY(EditDefaultsOnly, Category=Roll) float MaxRollSpeed = 600.f;
-	UPROPERTY(EditDefaultsOnly, Category=Roll) float BrakingDecelerationRolling = 2000.f;
-	UPROPERTY(EditDefaultsOnly, Category=Roll) bool bCanWalkOffLedgeWhenRolling = true;
-	
-	float RollTime;
+	int32 RollTicksLeft;
+	int32 RollCooldownTicksLeft;
 	FVector RollDirection;
-	bool bHasRollRecently;
-	FTimerHandle RollResetTimerHandle;
 	
 	void ExitRoll();
 	void PhysRoll(float deltaTime, int32 Iterations);
 	bool CanRoll() const;
-	void ResetRoll();
 
 	UFUNCTION(Server, Reliable) void Server_EnterRoll();
 
 	// CLIMBING
+public:
+	/** Climbing timers count simulation ticks, FinishClimbingTimer is called on the owner when they expire */
+	void SetClimbingTimer(float Duration);
+	void ClearClimbingTimer();
+
+	/**
+	 * Replaces LaunchCharacter for climb jumps. The launch starts inside the next move and follows the arc as a
+	 * FRootMotionSource_AdventureLaunch, so it is part of the saved move and replayed and corrected like any root motion source.
+	 */
+	void LaunchAlongArc(const FVector& LaunchVelocity, float Duration);
+	/** Ends a running launch, e.g. once a ledge is grabbed mid-air */
+	void StopLaunch();
+
+	static const FName LaunchRootMotionName;
+
 private:
+	int32 ClimbingTimerTicksLeft;
+	/** Bumped whenever a timer starts, stops or expires, so replayed moves only rewind the timer they were saved with */
+	uint16 ClimbingTimerSerial;
+	/** Set while replaying a move saved before the running timer started */
+	bool bReplayingStaleClimbingTimer;
+
+	/** Server side limit on launches sent by clients, their speed is checked against UClimbingComponent::GetMaxClimbJumpSpeed */
+	UPROPERTY(EditDefaultsOnly, Category=Climbing) float MaxLaunchDuration = 3.f;
+
+	void ApplyPendingLaunch();
+
 	void PhysClimbing(float deltaTime, int32 Iterations);
+
+	// FIXED TIMESTEP
+public:
+	float GetSimulationTimeStep() const { return 1.f / SimTickRate; }
+	int32 SecondsToSimTicks(float Seconds) const;
+	uint32 GetSimulationTick() const { return SimulationTick; }
+
+	/** Switches the custom mode clock at runtime, the async physics clock falls back to fixed steps when physics doesn't tick async */
+	void SetSimulationClock(bool bFixedTimestep, bool bAsyncPhysicsClock);
+
+	virtual void AsyncPhysicsTickComponent(float DeltaTime, float SimTime) override;
+
+private:
+	/** Runs the custom movement modes in fixed steps and interpolates the mesh between them */
+	UPROPERTY(EditDefaultsOnly, Category=FixedTimestep) bool bUseFixedTimestep = false;
+	UPROPERTY(EditDefaultsOnly, Category=FixedTimestep, meta=(ClampMin=10)) int32 FixedTickRate = 60;
+	UPROPERTY(EditDefaultsOnly, Category=FixedTimestep, meta=(ClampMin=1)) int32 MaxSimTicksPerMove = 8;
+
+	/**
+	 * Count fixed steps on the async physics tick instead of the move's delta time, so custom modes step at the
+	 * physics rate whatever the frame rate. Only used for pawns no remote client predicts (AI, listen host, standalone),
+	 * predicted moves keep stepping from their delta so server replays match the client. Needs Tick Physics Async.
+	 *
+	 * Not done: running PhysSlide, PhysRoll and PhysClimbing on the physics thread. They sweep and move scene components
+	 * through the character movement component, which is game thread only, so only the step count crosses over and
+	 * every step still costs game thread time. This mode changes how many steps a frame runs, not where they run.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category=FixedTimestep, meta=(EditCondition="bUseFixedTimestep")) bool bUseAsyncPhysicsClock = false;
+
+	/** Physics steps since the game thread last consumed them, incremented on the physics thread */
+	std::atomic<int32> AsyncPhysicsSteps{0};
+	bool bAsyncPhysicsClockActive = false;
+	/** Rate the steps run at, FixedTickRate or the async physics rate while that clock is active */
+	int32 SimTickRate = 60;
+
+	bool UsesAsyncPhysicsClock() const;
+
+	float SimTimeAccumulator;
+	/** Custom mode time not yet covered by a fixed step, carried into the next physics update */
+	float StepTimeAccumulator;
+	int32 PendingSimTicks;
+	uint32 SimulationTick;
+	FVector PreviousStepLocation;
+	bool bMeshStepOffsetApplied;
+
+	void AdvanceSimulationClock(float DeltaSeconds);
+	void TickSimulationTimers();
+	void PhysCustomMode(float deltaTime, int32 Iterations);
+	void PhysCustomFixed(float deltaTime, int32 Iterations);
+	void UpdateFixedStepInterpolation();
+
+	// HISTORY
+public:
+	/**
+	 * Server side check that the character was within grab reach of GrabLocation around ClaimTime.
+	 * Times are client move time stamps for remote clients and world time otherwise.
+	 */
+	bool CanReachLedgeFromHistory(float ClaimTime, const FVector& GrabLocation) const;
+	bool GetMovementStateAtTime(float Time, FAdventureMovementState& OutState) const;
+	const FAdventureMovementHistory& GetMovementHistory() const { return MovementHistory; }
+	float GetMaxLedgeGrabReach() const { return MaxLedgeGrabReach; }
+
+private:
+	UPROPERTY(EditDefaultsOnly, Category=History) bool bRecordMovementHistory = true;
+	UPROPERTY(EditDefaultsOnly, Category=History) int32 MovementHistoryCapacity = 256;
+	UPROPERTY(EditDefaultsOnly, Category=History) float MaxLedgeGrabReach = 150.f;
+	UPROPERTY(EditDefaultsOnly, Category=History) float HistoryRewindTolerance = 0.25f;
+
+	FAdventureMovementHistory MovementHistory;
+
+	void RecordMovementHistory();
 	
 public:
 	virtual bool IsMovingOnGround() const override;
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "AdventureMovementConfig.generated.h"
+
+/** Sprint, slide and roll tuning shared by every movement component that references the asset */
+UCLASS(BlueprintType)
+class SHOOTERADVENTURE_API UAdventureMovementConfig : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Sprint) float MaxSprintSpeed = 750.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Slide) float MaxSlideSpeed = 300.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Slide) float Slide_EnterImpulse = 500.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Slide) float Slide_GravityForce = 5000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Slide) float Slide_Friction = 1.3f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Slide) float BrakingDecelerationSliding = 500.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Roll) float RollTimeDuration = 1.3f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Roll) float RollDelayBetweenRolls = 0.25f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Roll) float MaxRollSpeed = 600.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Roll) float BrakingDecelerationRolling = 2000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Roll) bool bCanWalkOffLedgeWhenRolling = true;
+};
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Quantized movement sample. Location is stored in 1/10 cm units and velocity in cm/s,
+ * which keeps a sample at 24 bytes while matching FVector_NetQuantize10 precision.
+ */
+struct FAdventureMovementSample
+{
+	int32 Location[3];
+	int16 Velocity[3];
+	uint8 MovementMode;
+	uint8 CustomMovementMode;
+	uint8 ClimbingState;
+	uint8 Padding;
+};
+
+/** Decoded movement state returned by history lookups */
+struct FAdventureMovementState
+{
+	float Timestamp = 0.f;
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	uint8 MovementMode = 0;
+	uint8 CustomMovementMode = 0;
+	uint8 ClimbingState = 0;
+};
+
+/**
+ * Fixed capacity ring buffer of movement samples used by the server to validate and rewind movement.
+ * Timestamps live in their own array so time lookups only touch 4 bytes per sample.
+ * Append is O(1), time lookup is a binary search over the logical (oldest to newest) order.
+ */
+class SHOOTERADVENTURE_API FAdventureMovementHistory
+{
+public:
+	/** Allocates storage once. Capacity is rounded up to the next power of two. */
+	void Init(int32 InCapacity);
+	void Reset();
+
+	void Add(float Timestamp, const FVector& Location, const FVector& Velocity, uint8 MovementMode, uint8 CustomMovementMode, uint8 ClimbingState);
+
+	int32 Num() const { return Count; }
+	int32 GetCapacity() const { return Timestamps.Num(); }
+	bool IsEmpty() const { return Count == 0; }
+	float GetOldestTime() const { return IsEmpty() ? 0.f : Timestamps[ToPhysical(0)]; }
+	float GetNewestTime() const { return IsEmpty() ? 0.f : Timestamps[ToPhysical(Count - 1)]; }
+
+	/** Logical index 0 is the oldest sample */
+	FAdventureMovementState GetState(int32 Index) const;
+
+	/** Newest logical index whose timestamp is <= Time, INDEX_NONE when Time is older than the history */
+	int32 FindIndexAtTime(float Time) const;
+
+	/** State at Time, interpolating location and velocity between the surrounding samples */
+	bool GetStateAtTime(float Time, FAdventureMovementState& OutState) const;
+
+	/** True if any sample inside [StartTime, EndTime] lies within Radius of Location */
+	bool WasWithinRadius(float StartTime, float EndTime, const FVector& Location, float Radius) const;
+
+	/** Heap memory owned by the history, constant after Init */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	int32 ToPhysical(int32 LogicalIndex) const { return (Head + LogicalIndex) & Mask; }
+	FVector DecodeLocation(const FAdventureMovementSample& Sample) const;
+
+	TArray<float> Timestamps;
+	TArray<FAdventureMovementSample> Samples;
+	int32 Head = 0;
+	int32 Count = 0;
+	int32 Mask = 0;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Movement modes as the telemetry buckets them, custom modes get their own bucket */
+enum class EAdventureTelemetryMode : uint8
+{
+	Other,
+	Walking,
+	Falling,
+	Swimming,
+	Flying,
+	Slide,
+	Roll,
+	Climbing,
+	Num
+};
+
+/**
+ * Movement counters fed by the adventure movement component and character. Every frame they go to the
+ * AdventureMovement and AdventureClimbing CSV profiler categories when those are compiled in, and they are
+ * accumulated for Adventure.MovementTelemetry.Report, which writes a file and so also works in Shipping.
+ * Disabled through Adventure.MovementTelemetry by default, callers only pay for the IsEnabled check.
+ * Counters are bumped atomically, so worker and physics thread callers can record too.
+ */
+class SHOOTERADVENTURE_API FAdventureMovementTelemetry
+{
+public:
+	static bool IsEnabled() { return bEnabled; }
+
+	static EAdventureTelemetryMode GetMode(uint8 MovementMode, uint8 CustomMode);
+
+	static void RecordCharacterFrame(uint8 MovementMode, uint8 CustomMode, uint8 ClimbingState);
+	static void RecordModeTransition(uint8 PreviousMovementMode, uint8 PreviousCustomMode, uint8 MovementMode, uint8 CustomMode);
+	static void RecordClimbingTransition(uint8 PreviousState, uint8 NewState);
+	static void RecordSceneQuery(uint8 MovementMode, uint8 CustomMode);
+	static void RecordFailedLaunch();
+	static void RecordFailedHopUp();
+
+	/** Allocator calls across all threads so far, for deltas around code that should not allocate. Always 0 in Shipping */
+	static uint64 GetAllocationCount();
+
+	static void Reset();
+
+	/** Writes the accumulated totals to Saved/Profiling/MovementTelemetry.csv and the log */
+	static void WriteReport();
+
+	/** Climbing states fit in 3 bits on the wire */
+	static constexpr int32 NumClimbingStates = 8;
+	static constexpr int32 NumModes = (int32)EAdventureTelemetryMode::Num;
+
+	/** Mirrors Adventure.MovementTelemetry */
+	static bool bEnabled;
+	static void OnEnabledChanged(IConsoleVariable* Variable);
+
+private:
+	struct FCounters
+	{
+		int32 Modes[NumModes] = {};
+		int32 ClimbingStates[NumClimbingStates] = {};
+		int32 SceneQueries[NumModes] = {};
+		int32 ModeTransitions = 0;
+		int32 ClimbingTransitions = 0;
+		int32 FailedLaunches = 0;
+		int32 FailedHopUps = 0;
+	};
+
+	/** Totals since the last reset, Modes and ClimbingStates count character frames */
+	struct FTotals
+	{
+		int64 Frames = 0;
+		int64 Modes[NumModes] = {};
+		int64 ClimbingStates[NumClimbingStates] = {};
+		int64 SceneQueries[NumModes] = {};
+		int32 ModeTransitions[NumModes][NumModes] = {};
+		int32 ClimbingTransitions[NumClimbingStates][NumClimbingStates] = {};
+		int64 FailedLaunches = 0;
+		int64 FailedHopUps = 0;
+	};
+
+	static FCounters Frame;
+	static FTotals Totals;
+	static FDelegateHandle EndFrameHandle;
+
+	static void EndFrame();
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AdventureNetHarness.generated.h"
+
+class AClimbingStressLevelGenerator;
+class ALedge;
+class AShooterAdventureCharacter;
+
+/**
+ * Plays a scripted movement loop through every movement mode on the local player of each game world and
+ * appends the client corrections recorded on the way to Saved/Profiling/NetCorrections.csv.
+ * Every world, a dedicated server included, builds the same climbing wall in front of the first player start
+ * so the climb step has a ledge that resolves on both ends.
+ * Run a listen server with clients in one process and set Adventure.NetHarness.Loops, network
+ * conditions come from the engine's NetEmulation cvars and are written next to the results.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API UAdventureNetHarness : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Appends the correction stats of every adventure movement component in the world to the CSV */
+	static void WriteReport(UWorld* World);
+
+	static void ResetCorrectionStats(UWorld* World);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EStep : uint8
+	{
+		Walk,
+		Sprint,
+		Slide,
+		Roll,
+		Jump,
+		Climb,
+		Num
+	};
+
+	bool bRunning = false;
+	bool bFinished = false;
+	bool bCourseSpawned = false;
+	int32 LoopsDone = 0;
+	int32 StepIndex = 0;
+	float StepTime = 0.f;
+
+	TWeakObjectPtr<AClimbingStressLevelGenerator> Course;
+
+	AShooterAdventureCharacter* GetLocalCharacter() const;
+	EStep GetStep() const { return static_cast<EStep>(StepIndex); }
+	float GetStepDuration() const;
+	void SpawnCourse();
+	void DestroyCourse();
+	const ALedge* FindCourseLedge() const;
+	void TickClimbStep(AShooterAdventureCharacter* Character);
+	void EnterStep(AShooterAdventureCharacter* Character);
+	void ExitStep(AShooterAdventureCharacter* Character);
+	void FinishScript(AShooterAdventureCharacter* Character);
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "AdventureReplicationGraph.generated.h"
+
+class AShooterAdventureCharacter;
+class UNetConnection;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+enum class EAdventureClassRepPolicy : uint8
+{
+	NotRouted,
+	RelevantAllConnections,
+	/** bOnlyRelevantToOwner actors, only the owning connection gathers them */
+	RelevantOwnerConnection,
+	/** Spatialized, location refreshed every frame */
+	Spatialize_Dynamic
+};
+
+/** Replication period used for climbing characters up to MaxDistance from the closest viewer */
+USTRUCT()
+struct FAdventureRepFrequencyBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config) float MaxDistance = 0.f;
+	UPROPERTY(config) int32 ReplicationPeriodFrame = 1;
+};
+
+/** Lowers the replication rate of climbing characters that are far from every viewer of a connection */
+UCLASS()
+class SHOOTERADVENTURE_API UAdventureReplicationGraphNode_ClimbingFrequency : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UAdventureReplicationGraphNode_ClimbingFrequency();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	/** Sorted by distance, past the last bucket its period applies */
+	TArray<FAdventureRepFrequencyBucket> Buckets;
+
+private:
+	TArray<AShooterAdventureCharacter*> Characters;
+	/** Bucketed once per frame, connections only visit the characters whose period changes */
+	TArray<AShooterAdventureCharacter*> ClimbingCharacters;
+	TArray<AShooterAdventureCharacter*> StoppedClimbingCharacters;
+
+	uint32 GetClimbingPeriodFrame(const AShooterAdventureCharacter* Character, const FNetViewerArray& Viewers) const;
+};
+
+/**
+ * Replication graph for the project. Characters are spatialized on a 2D grid, game state and other
+ * always relevant info actors go to every connection, and owner only actors to their owner's connection.
+ */
+UCLASS(transient, config=Engine)
+class SHOOTERADVENTURE_API UAdventureReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UAdventureReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Smoothed game thread time of ServerReplicateActors */
+	double GetAverageReplicateMs() const { return AverageReplicateMs; }
+
+	UPROPERTY(config) float SpatialCellSize = 10000.f;
+	UPROPERTY(config) FVector2D SpatialBias = FVector2D(-150000.f, -150000.f);
+	UPROPERTY(config) TArray<FAdventureRepFrequencyBucket> ClimbingFrequencyBuckets;
+
+private:
+	UPROPERTY() UReplicationGraphNode_GridSpatialization2D* GridNode;
+	UPROPERTY() UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+	UPROPERTY() UAdventureReplicationGraphNode_ClimbingFrequency* ClimbingFrequencyNode;
+
+	/** Owner only actors of each client connection */
+	UPROPERTY() TMap<UNetConnection*, UReplicationGraphNode_ActorList*> OwnerConnectionNodes;
+	/** Owner only actors that had no owning connection yet when they were routed */
+	TArray<FNewReplicatedActorInfo> PendingOwnerConnectionActors;
+
+	/** False when the actor has no owning connection yet */
+	bool AddToOwnerConnectionNode(const FNewReplicatedActorInfo& ActorInfo);
+
+	TClassMap<EAdventureClassRepPolicy> ClassRepPolicies;
+	EAdventureClassRepPolicy GetClassRepPolicy(UClass* Class);
+
+	double AverageReplicateMs = 0.0;
+};
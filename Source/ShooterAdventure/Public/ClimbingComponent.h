@@ -4,10 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Ledge.h"
+#include "ClimbingQueryScheduler.h"
+#include "ClimbingConfig.h"
 #include "ClimbingComponent.generated.h"
 
 
 class UCapsuleComponent;
+class ASplineLedge;
+class UClimbingProbeBatch;
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class SHOOTERADVENTURE_API UClimbingComponent : public UActorComponent
 {
@@ -20,87 +25,243 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void OnRegister() override;
+
+public:
+	virtual void PostLoad() override;
+
+	// Only enabled by the owner while falling, interpolating or hanging
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Shared tuning and montages, the class defaults of UClimbingConfig are used when none is set */
+	UPROPERTY(EditDefaultsOnly, Category=Climbing) TObjectPtr<UClimbingConfig> ClimbingConfig;
+
+	const UClimbingConfig& GetConfig() const { return *Config; }
+
+	/** Ignores the owner and its child actors, built once at BeginPlay */
+	const FCollisionQueryParams& GetIgnoreOwnerParams() const { return QueryContext.Params; }
 
 private:
+	/** Resolved on register, the class defaults until then, never null */
+	const UClimbingConfig* Config = nullptr;
+
+#if WITH_EDITORONLY_DATA
+	// Moved to UClimbingConfig, PostLoad carries values saved on blueprints over into a config owned by the blueprint
+	UPROPERTY(meta=(DeprecatedProperty)) FVector TraceOrigin_DEPRECATED = FVector(0,0,60);
+	UPROPERTY(meta=(DeprecatedProperty)) float CapsuleTraceRadius_DEPRECATED = 30;
+	UPROPERTY(meta=(DeprecatedProperty)) float CapsuleTraceHeight_DEPRECATED = 50;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxTraceDistance_DEPRECATED = 100;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxTraceHeight_DEPRECATED = 50;
+	UPROPERTY(meta=(DeprecatedProperty)) int32 TopTraceIterations_DEPRECATED = 20;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxTopTraceDepth_DEPRECATED = 100;
+	UPROPERTY(meta=(DeprecatedProperty)) float MinAllowedDepthToClimbUp_DEPRECATED = 70;
+	UPROPERTY(meta=(DeprecatedProperty)) float ForwardOffsetFromLedge_DEPRECATED = 47.0f;
+	UPROPERTY(meta=(DeprecatedProperty)) float VerticalOffsetFromLedge_DEPRECATED = 52.0f;
+	UPROPERTY(meta=(DeprecatedProperty)) FVector ClimbUpOffset_DEPRECATED = FVector(-50,0,0);
+	UPROPERTY(meta=(DeprecatedProperty)) int32 SideIterations_DEPRECATED = 20;
+	UPROPERTY(meta=(DeprecatedProperty)) float MinSideDistance_DEPRECATED = 40.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float CornerOutDepth_DEPRECATED = 50.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float CornerInDepth_DEPRECATED = 50.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxRangeToFindLedge_DEPRECATED = 700;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxJumpSpeed_DEPRECATED = 1000;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxAngleToLaunch_DEPRECATED = 60.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxJumpUpHeight_DEPRECATED = 200.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxHopUpHeight_DEPRECATED = 100.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxJumpUpVelocity_DEPRECATED = 400.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MinDistanceToSuggestVelocity_DEPRECATED = 150.f;
+	UPROPERTY(meta=(DeprecatedProperty)) float MaxSideJumpDistance_DEPRECATED = 1500.f;
+
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* ClimbUpMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* DropClimbMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* RightCornerOutMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* LeftCornerOutMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* RightCornerInMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* LeftCornerInMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* HopUpMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* ClimbJumpRightMontage_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty)) UAnimMontage* ClimbJumpLeftMontage_DEPRECATED;
+#endif
+
 	FVector GetTraceOrigin() const;
+
+	/** Scene query state reused by every probe, so hanging and shimmying never touch the heap once warmed up */
+	struct FClimbingQueryContext
+	{
+		/** Ignores the owner and its child actors, built once at BeginPlay */
+		FCollisionQueryParams Params;
+		FCollisionQueryParams ComponentParams;
+		/** Room checks at hang targets, with the capsule's own sweep responses */
+		FCollisionQueryParams CapsuleParams;
+		FCollisionResponseParams CapsuleResponseParams;
+		TArray<FHitResult> SweepHits;
+		TArray<FHitResult> LineHits;
+		TArray<FOverlapResult> Overlaps;
+
+		SIZE_T GetAllocatedSize() const;
+	};
+	mutable FClimbingQueryContext QueryContext;
+
+	void BuildQueryContext();
+	const FCollisionQueryParams& GetQueryParams(const TStatId& StatId) const;
+	bool IsCapsuleBlockedAt(const FVector& Location, const FQuat& Rotation, const TStatId& StatId) const;
+
+	/** Attributes one scene query to the owner's movement mode when movement telemetry is on */
+	void RecordSceneQuery() const;
+
+	/** Query simple ledge proxies by object type instead of TraceChannel against full level collision */
+	UPROPERTY(EditDefaultsOnly, Category=Collision) bool bUseLedgeProxies = true;
+	UPROPERTY(EditDefaultsOnly, Category=Collision) TArray<TEnumAsByte<EObjectTypeQuery>> ClimbProxyObjectTypes;
+	FCollisionObjectQueryParams ClimbProxyObjectParams;
+
+	bool SweepClimbable(FHitResult& Hit, const FVector& Start, const FVector& End, const FCollisionShape& Shape) const;
+	/** Results land in the query context buffers */
+	bool SweepClimbableMulti(const FVector& Start, const FVector& End, const FCollisionShape& Shape) const;
+	bool OverlapClimbable(const FVector& Location, const FCollisionShape& Shape) const;
+	void CollectReachableGrabPoints(const TArray<FOverlapResult>& Overlaps, const FVector& MoveDirection, TArray<FLedgeGrabPoint>& OutGrabPoints) const;
+	UClimbingQueryScheduler* GetQueryScheduler() const;
+	UClimbingProbeBatch* GetProbeBatch() const;
+	/** Sweep against a single ledge only */
+	bool SweepLedge(const AActor* Ledge, FHitResult& Hit, const FVector& Start, const FVector& End, const FCollisionShape& Shape) const;
+	/** Downward trace onto the geometry that produced ForwardHit */
+	bool TraceLedgeTop(const FHitResult& ForwardHit, const FVector& Start, const FVector& End, FHitResult& TopHit) const;
 	
 	UPROPERTY(EditDefaultsOnly) TEnumAsByte<ETraceTypeQuery> TraceChannel;
-	UPROPERTY(EditDefaultsOnly) FVector TraceOrigin = FVector(0,0,60);	
-	UPROPERTY(EditDefaultsOnly) float CapsuleTraceRadius = 30;
-	UPROPERTY(EditDefaultsOnly) float CapsuleTraceHeight = 50;
-	UPROPERTY(EditDefaultsOnly) float MaxTraceDistance = 100;
-	UPROPERTY(EditDefaultsOnly) float MaxTraceHeight = 50;
-	UPROPERTY(EditDefaultsOnly) int TopTraceIterations = 20;
-	UPROPERTY(EditDefaultsOnly) float MaxTopTraceDepth = 100;
-	UPROPERTY(EditDefaultsOnly) float MinAllowedDepthToClimbUp = 70;
-	UPROPERTY(EditDefaultsOnly, Category=Character) float ForwardOffsetFromLedge = 47.0f;
-	UPROPERTY(EditDefaultsOnly, Category=Character) float VerticalOffsetFromLedge = 52.0f;
-	UPROPERTY(EditDefaultsOnly, Category=Character) FVector ClimbUpOffset = FVector(-50,0,0);
-	UPROPERTY(EditDefaultsOnly, Category=SideCasting) int SideIterations = 20;
-	UPROPERTY(EditDefaultsOnly, Category=SideCasting) float MinSideDistance = 40.f;
-	UPROPERTY(EditDefaultsOnly, Category=Corner) float CornerOutDepth = 50.f;
-	UPROPERTY(EditDefaultsOnly, Category=Corner) float CornerInDepth = 50.f;
-	UPROPERTY(EditDefaultsOnly, Category=Launch) float MaxRangeToFindLedge = 700;
-	UPROPERTY(EditDefaultsOnly) float MaxJumpSpeed = 1000;
-	UPROPERTY(EditDefaultsOnly) float MaxAngleToLaunch = 60.f;
+
+	/** Predict the falling path against the ledge registry instead of probing every tick. Needs ledge proxies. */
+	UPROPERTY(EditDefaultsOnly, Category=Prefetch) bool bPrefetchLedges = true;
+
+	struct FLedgePrefetch
+	{
+		TWeakObjectPtr<ALedge> Ledge;
+		FLedgeGrabPoint Point;
+		/** Trace origin height at which the ledge gets grabbed */
+		float GrabZ = 0.f;
+		FVector Velocity = FVector::ZeroVector;
+		double Time = 0.0;
+		bool bPredicted = false;
+	};
+	FLedgePrefetch Prefetch;
+
+	/** Hand the falling probes to UClimbingProbeBatch, it runs them for all characters at once ahead of the climbing update */
+	UPROPERTY(EditDefaultsOnly, Category=Collision) bool bBatchProbes = true;
+
+	/** Falling probe run by the batch, only valid during the frame it was gathered in */
+	struct FBatchedProbe
+	{
+		uint64 Frame = MAX_uint64;
+		FVector Velocity = FVector::ZeroVector;
+		bool bSearchLedge = false;
+		bool bNearLedge = false;
+		bool bFoundLedge = false;
+		FHitResult FwdHit;
+		FHitResult TopHit;
+	};
+	FBatchedProbe BatchedProbe;
+
+	bool HasBatchedProbe() const { return BatchedProbe.Frame == GFrameCounter; }
+	bool QueryNearClimbableGeometry(const FVector& Velocity) const;
+
+	void PredictLedge(const FVector& Velocity, float GravityZ, const AActor* IgnoredLedge);
 	
 public:
 	UPROPERTY(EditAnywhere, Category=Debugging) bool DebugTrace = false;
 	
 private:	
-	UPROPERTY(EditDefaultsOnly, Category=ClimbJump) float MaxJumpUpHeight = 200.f;
-	UPROPERTY(EditDefaultsOnly, Category=ClimbJump) float MaxHopUpHeight = 100.f;
-	UPROPERTY(EditDefaultsOnly, Category=ClimbJump) float MaxJumpUpVelocity = 400.f;
-	UPROPERTY(EditDefaultsOnly, Category=Launch) float MinDistanceToSuggestVelocity = 150.f;
-	UPROPERTY(EditDefaultsOnly, Category=ClimbJump) float MaxSideJumpDistance = 1500.f;
-
 	TObjectPtr<UCapsuleComponent> CapsuleComponent;
 
-	bool IsPossibleToReach(const USceneComponent* Candidate, FVector& TossVelocity, float Gravity) const;
-	bool FoundSuggestVelocity(FVector& TossVelocity, FVector StartLocation, FVector EndLocation, float MaxSpeed, float Gravity) const;
+	bool IsPossibleToReach(const FLedgeGrabPoint& Candidate, FVector& TossVelocity, float Gravity) const;
+	bool FoundSuggestVelocity(FVector& TossVelocity, const FVector& StartLocation, const FVector& EndLocation, float MaxSpeed, float Gravity) const;
+	FVector GetHangLocation(const FVector& WallPoint, float TopZ, const FVector& WallNormal) const;
 public:
 	
-	FHitResult GetForwardHit(FVector TraceStartOrigin, FVector TraceDirection, float TraceHeight) const;
-	FHitResult GetTopHit(FHitResult forwardHit, FVector TraceDirection, FVector TraceStartOrigin) const;
+	/** Cheap overlap against the climb channel, sized to cover the fall until the next idle wakeup */
+	bool IsNearClimbableGeometry(const FVector& Velocity) const;
+	/** FoundLedge for the falling update, answered from this frame's batched probe when there is one */
+	bool FoundFallingLedge(FHitResult& FwdHit, FHitResult& TopHit) const;
+	bool GetForwardHit(FHitResult& FwdHit, const FVector& TraceStartOrigin, const FVector& TraceDirection, float TraceHeight) const;
+	bool GetTopHit(FHitResult& TopHit, const FHitResult& FwdHit, const FVector& TraceDirection, const FVector& TraceStartOrigin) const;
 	bool FoundLedge(FHitResult &FwdHit, FHitResult &TopHit) const;
-	FVector GetCharacterLocationOnLedge(FHitResult FwdHit, FHitResult TopHit) const;
-	FRotator GetCharacterRotationOnLedge(FHitResult FwdHit) const;
+	FVector GetCharacterLocationOnLedge(const FHitResult& FwdHit, const FHitResult& TopHit) const;
+	FRotator GetCharacterRotationOnLedge(const FHitResult& FwdHit) const;
 
-	TArray<USceneComponent*> GetReachableGrabPoints(FVector MoveDirection) const;
-	bool GetValidLaunchVelocity(TArray<USceneComponent*> GrabPoints,FVector& LaunchVelocity, float Gravity) const;
+	bool GetValidLaunchVelocity(const TArray<FLedgeGrabPoint>& GrabPoints, FVector& LaunchVelocity, float Gravity) const;
 	bool CanClimbUp(FVector& TargetClimbLocation) const;
 	bool CanMoveInDirection(float HorizontalDirection, AActor* CurrentLedgeActor, FVector& TargetEdgeLocation) const;
 	bool CanCornerOut(float MoveDirection, FVector& CornerLocation, FRotator& CornerRotation) const;
+	/** Corner lookup in the ledge's precomputed adjacency, falls back to CanCornerOut for unlinked geometry */
+	bool FindLedgeCorner(const ALedge* Ledge, float MoveDirection, FVector& CornerLocation, FRotator& CornerRotation, bool& bInside) const;
 	bool CanHopUp(FVector& TargetLocation) const;
 	bool FoundSideLedge(AActor* CurrentLedge, FVector SideDirection, FVector& LaunchSpeed, float Gravity, float& Duration)  const;
 	FVector GetJumpUpVelocity(float Gravity) const;
+	FVector GetSideJumpFallbackVelocity(const FVector& SideDirection) const;
+	/** Fastest launch any climb jump can ask for, the server rejects faster ones */
+	float GetMaxClimbJumpSpeed() const;
 
-	// Montages
-public:		
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* ClimbUpMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* DropClimbMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* RightCornerOutMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* LeftCornerOutMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* RightCornerInMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* LeftCornerInMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* HopUpMontage;
+	// Scheduled variants, results arrive through the callback one frame later at the earliest
+	using FGrabPointsCallback = TFunction<void(const TArray<FLedgeGrabPoint>& GrabPoints)>;
+	using FLaunchCallback = TFunction<void(bool bFound, const FVector& LaunchVelocity)>;
+	using FSideLedgeCallback = TFunction<void(bool bFound, const FVector& LaunchVelocity, float Duration)>;
 
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* ClimbJumpRightMontage;
-	
-	UPROPERTY(EditDefaultsOnly, Category=Climbing)
-	UAnimMontage* ClimbJumpLeftMontage;
+	/** The overlap runs as an async scene query, candidate filtering on the scheduler once it returns */
+	void RequestReachableGrabPoints(const FVector& MoveDirection, FGrabPointsCallback&& OnComplete);
+	/** RequestReachableGrabPoints followed by the launch candidate solve in the same scheduled query */
+	void RequestLaunchVelocity(const FVector& MoveDirection, float Gravity, FLaunchCallback&& OnComplete);
+	/** The forward sweeps run as async scene queries, then each step's top traces are one scheduled query */
+	void RequestSideLedge(AActor* CurrentLedge, const FVector& SideDirection, float Gravity, FSideLedgeCallback&& OnComplete);
+	/** Pending callbacks of this component are dropped without running, async scene queries in flight included */
+	void CancelRequests();
+	EClimbingQueryPriority GetQueryPriority() const;
+
+private:
+	/** Side jump search state shared by its async sweeps and scheduled steps */
+	struct FSideLedgeSearch
+	{
+		TWeakObjectPtr<AActor> CurrentLedge;
+		FVector SideDirection = FVector::ZeroVector;
+		FVector Forward = FVector::ZeroVector;
+		FVector FirstStartTrace = FVector::ZeroVector;
+		float Step = 0.f;
+		float Gravity = 0.f;
+		/** Forward sweep result per step, no blocking hit when the sweep found nothing */
+		TArray<FHitResult> FwdHits;
+		int32 NumPendingSweeps = 0;
+		int32 NextStep = 0;
+		uint32 RequestSerial = 0;
+		FSideLedgeCallback OnComplete;
+	};
+
+	/** Bumped by CancelRequests, async scene query results of older requests are dropped */
+	uint32 RequestSerial = 0;
+
+	int32 GetNumSideLedgeSteps(float& OutStep) const;
+	FVector GetSideLedgeTraceStart(const FVector& SideDirection, const FVector& Forward) const;
+	/** Top traces and launch solve for one side step whose forward sweep already hit */
+	bool TestSideLedgeStep(const FHitResult& FwdHit, const AActor* CurrentLedge, const FVector& Forward, const FVector& StartTrace, float Gravity, FVector& LaunchSpeed, float& Duration) const;
+	void ScheduleSideLedgeStep(const TSharedRef<FSideLedgeSearch>& Search);
+
+public:
+
+	FVector GetCharacterLocationOnEdge(const FLedgeGrabPoint& EdgePoint) const;
+	FRotator GetCharacterRotationOnEdge(const FLedgeGrabPoint& EdgePoint) const;
+
+	// Falling prefetch
+	bool CanPrefetchLedges() const { return bPrefetchLedges && bUseLedgeProxies; }
+	/**
+	 * Keeps the predicted ledge up to date, false when nothing is predicted and the probes should run as usual.
+	 * The prediction only picks a candidate, bOutReached tells when to confirm it with the forward and top probes
+	 */
+	bool UpdateLedgePrefetch(const FVector& Velocity, float GravityZ, const AActor* IgnoredLedge, bool& bOutReached);
+	void ResetLedgePrefetch() { Prefetch = FLedgePrefetch(); }
+
+	// Probe batch
+	/** Game thread, false when this frame's falling probe should run inline instead */
+	bool PrepareBatchedProbe();
+	/** Worker thread while the game thread waits, only touches this component's query buffers */
+	void RunBatchedProbe();
+
+	// Spline ledges, analytic replacements for the hang, shimmy and corner probes
+	bool GetHangOnSplineLedge(const ASplineLedge* Ledge, FVector& Location, FRotator& Rotation, float& EdgeDistance) const;
+	bool CanMoveAlongSplineLedge(const ASplineLedge* Ledge, float EdgeDistance, float HorizontalDirection) const;
+	bool FindSplineLedgeCorner(const ASplineLedge* Ledge, float EdgeDistance, float HorizontalDirection, FVector& CornerLocation, FRotator& CornerRotation, bool& bInside) const;
 };
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ClimbingConfig.generated.h"
+
+class UAnimMontage;
+
+/**
+ * Climbing tuning and montages shared by every character that references the asset.
+ * Treated as read only at runtime, edits in the editor apply to all users immediately.
+ */
+UCLASS(BlueprintType)
+class SHOOTERADVENTURE_API UClimbingConfig : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Tick interval used while falling away from any climbable geometry */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Ticking) float IdleFallingTickInterval = 0.1f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) FVector TraceOrigin = FVector(0,0,60);
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float CapsuleTraceRadius = 30;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float CapsuleTraceHeight = 50;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float MaxTraceDistance = 100;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float MaxTraceHeight = 50;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) int32 TopTraceIterations = 20;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float MaxTopTraceDepth = 100;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Tracing) float MinAllowedDepthToClimbUp = 70;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Character) float ForwardOffsetFromLedge = 47.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Character) float VerticalOffsetFromLedge = 52.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Character) FVector ClimbUpOffset = FVector(-50,0,0);
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=SideCasting) int32 SideIterations = 20;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=SideCasting) float MinSideDistance = 40.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Corner) float CornerOutDepth = 50.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Corner) float CornerInDepth = 50.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Launch) float MaxRangeToFindLedge = 700;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Launch) float MaxJumpSpeed = 1000;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Launch) float MaxAngleToLaunch = 60.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Launch) float MinDistanceToSuggestVelocity = 150.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float MaxJumpUpHeight = 200.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float MaxHopUpHeight = 100.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float MaxJumpUpVelocity = 400.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float MaxSideJumpDistance = 1500.f;
+	/** Side jump velocity when no ledge was found in that direction */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float SideJumpFallbackSpeed = 500.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=ClimbJump) float SideJumpFallbackUpSpeed = 600.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Prefetch) float PrefetchLookahead = 0.4f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Prefetch, meta=(ClampMin=1)) int32 PrefetchSegments = 4;
+	/** Difference from the predicted velocity that throws the prediction away */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Prefetch) float PrefetchVelocityTolerance = 50.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* ClimbUpMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* DropClimbMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* RightCornerOutMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* LeftCornerOutMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* RightCornerInMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* LeftCornerInMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* HopUpMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* ClimbJumpRightMontage;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Montages) UAnimMontage* ClimbJumpLeftMontage;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ClimbingProbeBatch.generated.h"
+
+class UClimbingComponent;
+class UClimbingProbeBatch;
+
+USTRUCT()
+struct FClimbingProbeBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UClimbingProbeBatch* Batch = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FClimbingProbeBatchTickFunction> : public TStructOpsTypeTraitsBase2<FClimbingProbeBatchTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * Runs the falling ledge probes of every climbing component as one parallel pass instead of one character at a time.
+ * Ticks in TG_PrePhysics ahead of the registered components: gathers the components that will probe this frame,
+ * runs their proximity, forward and top queries on worker threads and leaves the results on each component for its climbing update.
+ * The game thread waits for the workers, so nothing moves in the scene while they read it.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API UClimbingProbeBatch : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Makes the component's tick depend on the batch */
+	void Register(UClimbingComponent* Component);
+	void Unregister(UClimbingComponent* Component);
+
+	static bool IsEnabled();
+
+private:
+	friend FClimbingProbeBatchTickFunction;
+
+	void Run();
+
+	FClimbingProbeBatchTickFunction TickFunction;
+
+	/** Unregistered on EndPlay, so never dangling */
+	TArray<UClimbingComponent*> Components;
+	/** Components gathered this frame, kept to reuse the allocation */
+	TArray<UClimbingComponent*> Gathered;
+};
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ClimbingQueryScheduler.generated.h"
+
+UENUM()
+enum class EClimbingQueryPriority : uint8
+{
+	LocalPlayer,
+	RemotePlayer,
+	AI,
+	Num UMETA(Hidden)
+};
+
+/**
+ * Runs expensive climbing probes against a per-frame time budget instead of inside input handlers.
+ * Queries run on the game thread during the world tick, by priority and then in submission order.
+ * Every priority with pending work runs at least one query per frame, so lower priorities can't starve behind a
+ * busy one. Queries whose owner is gone or that were cancelled are dropped without running.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API UClimbingQueryScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Enqueue(const UObject* Owner, EClimbingQueryPriority Priority, TUniqueFunction<void()>&& Work);
+
+	/** Pending work of the owner is skipped, safe to call from inside a running query */
+	void Cancel(const UObject* Owner);
+
+	static EClimbingQueryPriority GetPriorityFor(const AActor* Actor);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FQuery
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		TUniqueFunction<void()> Work;
+	};
+
+	/** One FIFO per priority */
+	TArray<FQuery> Queues[(int32)EClimbingQueryPriority::Num];
+};
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ClimbingStressLevelGenerator.generated.h"
+
+class ALedge;
+
+USTRUCT(BlueprintType)
+struct FClimbingStressLevelSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation) int32 Seed = 1337;
+
+	/** Number of cells per side, each cell holds at most one climbing feature */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation, meta=(ClampMin=1)) int32 GridSize = 8;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation) float CellSize = 1500.f;
+
+	/** Chance for a cell to receive a feature */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation, meta=(ClampMin=0, ClampMax=1)) float Density = 0.8f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation) float GrabPointSpacing = 50.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Features) bool bWalls = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Features) bool bCorners = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Features) bool bHopUpStacks = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Features) bool bSideJumpGaps = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Features) bool bSlides = true;
+
+	/** Trace channel the climbing component probes with, ledges block it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Collision) TEnumAsByte<ECollisionChannel> ClimbableChannel = ECC_GameTraceChannel1;
+	/** Object type of slide ramps */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Collision) TEnumAsByte<ECollisionChannel> RampObjectChannel = ECC_GameTraceChannel2;
+};
+
+/**
+ * Builds a seeded climbing test world out of collision boxes and ledges, with no content dependency,
+ * so benchmarks and soak tests can run on any map, including headless with -nullrhi.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API AClimbingStressLevelGenerator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AClimbingStressLevelGenerator();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Generation) FClimbingStressLevelSettings Settings;
+	UPROPERTY(EditAnywhere, Category=Generation) bool bGenerateOnBeginPlay = true;
+
+	UFUNCTION(BlueprintCallable, CallInEditor, Category=Generation) void Generate();
+	UFUNCTION(BlueprintCallable, CallInEditor, Category=Generation) void Clear();
+
+	/** Single climbable wall at a known spot, its grab points run along the top of the local +X face. Cleared with the generated level. */
+	UFUNCTION(BlueprintCallable, Category=Generation) ALedge* AddWall(const FTransform& Transform, float Height, float Width);
+
+	static AClimbingStressLevelGenerator* SpawnGenerator(UWorld* World, const FClimbingStressLevelSettings& InSettings);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UPROPERTY(Transient) TArray<AActor*> GeneratedActors;
+
+	FRandomStream Stream;
+	int32 NumLedges = 0;
+	int32 NumGrabPoints = 0;
+
+	void GenerateCell(const FIntPoint& Cell, const FVector& CellOrigin);
+	void SpawnWall(const FTransform& Transform);
+	void SpawnCorner(const FTransform& Transform, bool bInside);
+	void SpawnHopUpStack(const FTransform& Transform);
+	void SpawnSideJumpGap(const FTransform& Transform);
+	void SpawnSlide(const FTransform& Transform);
+
+	AActor* SpawnBlock(const FTransform& Transform, const FVector& Extent, ECollisionChannel ObjectType = ECC_WorldStatic);
+
+	/** Block whose top front edge (local +X face) carries grab points */
+	ALedge* SpawnLedge(const FTransform& Transform, const FVector& Extent, bool bSideFaceGrabPoints = false);
+};
@@ -6,6 +6,57 @@
 #include "GameFramework/Actor.h"
 #include "Ledge.generated.h"
 
+class UBoxComponent;
+
+/** World space grab point returned by ledge queries */
+USTRUCT(BlueprintType)
+struct FLedgeGrabPoint
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) FVector Location = FVector::ZeroVector;
+
+	/** Points away from the wall, the character hangs facing -Normal */
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) FVector Normal = FVector::ForwardVector;
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) int32 Index = INDEX_NONE;
+};
+
+UENUM(BlueprintType)
+enum class ELedgeCornerType : uint8
+{
+	None,
+	/** The wall wraps away from the character */
+	Out,
+	/** The wall turns towards the character */
+	In
+};
+
+/** Precomputed move from the end of one ledge face onto an adjacent face */
+struct FLedgeCorner
+{
+	TWeakObjectPtr<ALedge> AdjacentLedge;
+	int32 AdjacentFace = INDEX_NONE;
+	ELedgeCornerType Type = ELedgeCornerType::None;
+
+	/** Grab point on the adjacent face next to the corner, world space */
+	FLedgeGrabPoint Target;
+	FRotator TargetRotation = FRotator::ZeroRotator;
+
+	bool IsValid() const { return Type != ELedgeCornerType::None && AdjacentLedge.IsValid(); }
+};
+
+/** Grab points sharing a normal. Ends are relative to a character hanging on the face. */
+struct FLedgeFace
+{
+	FVector3f Normal;
+	int32 LeftPoint = INDEX_NONE;
+	int32 RightPoint = INDEX_NONE;
+	FLedgeCorner Corners[2];
+
+	static constexpr int32 LeftEnd = 0;
+	static constexpr int32 RightEnd = 1;
+};
+
 UCLASS()
 class SHOOTERADVENTURE_API ALedge : public AActor
 {
@@ -18,9 +69,64 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PostInitializeComponents() override;
+	virtual void OnConstruction(const FTransform& Transform) override;
 
 public:
+	/** Object channel of simple climb proxies, climbing queries only look at this channel */
+	static constexpr ECollisionChannel ClimbProxyChannel = ECC_GameTraceChannel3;
+	static const FName ClimbProxyProfileName;
+
+	/** Legacy component grab points, folded into GrabPointTransforms on BeginPlay. Prefer GrabPointTransforms. */
 	UPROPERTY(BlueprintReadWrite) TArray<USceneComponent*> GrabPoints;
 
-	USceneComponent* GetClosestPoint(FVector Origin) const;
+	/** Actor space grab points, X is the ledge normal. Editable in the viewport and the only copy queries read. */
+	UPROPERTY(EditAnywhere, Category=Climbing, meta=(MakeEditWidget)) TArray<FTransform> GrabPointTransforms;
+
+	/** Query only box on the LedgeProxy channel. Extra primitives on that channel (e.g. convex hulls) act as proxies too. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Climbing) UBoxComponent* ClimbProxy;
+
+	/** Fit ClimbProxy to the bounds of the ledge's colliding primitives on construction */
+	UPROPERTY(EditAnywhere, Category=Climbing) bool bAutoFitClimbProxy = true;
+
+	UFUNCTION(BlueprintCallable, CallInEditor, Category=Climbing) void FitClimbProxy();
+
+	/** Moves legacy GrabPoints components into GrabPointTransforms and destroys the components */
+	UFUNCTION(BlueprintCallable, CallInEditor, Category=Climbing) void BakeGrabPointComponents();
+
+	/** Fills an actor space edge with points every Spacing units, inset half a spacing from both ends */
+	void AddGrabPointsAlongEdge(const FVector& LocalStart, const FVector& LocalEnd, const FVector& LocalNormal, float Spacing);
+
+	/** Rebuilds faces and corner links, call after editing GrabPointTransforms at runtime */
+	void RefreshGrabPoints();
+
+	UFUNCTION(BlueprintCallable, Category=Climbing) virtual bool GetClosestGrabPoint(FVector Origin, FLedgeGrabPoint& OutPoint) const;
+	FLedgeGrabPoint GetGrabPoint(int32 Index) const;
+	int32 GetNumGrabPoints() const { return GrabPointTransforms.Num(); }
+
+	SIZE_T GetGrabPointAllocatedSize() const;
+
+	/** World space bounds of everything a character can grab on this ledge */
+	virtual FBox GetGrabBounds() const;
+
+	const TArray<FLedgeFace>& GetFaces() const { return Faces; }
+	int32 GetFaceOfGrabPoint(int32 Index) const { return PointFaces.IsValidIndex(Index) ? PointFaces[Index] : INDEX_NONE; }
+
+	/** Corner reached by shimmying off the face of the given grab point, filled in by the ledge registry */
+	const FLedgeCorner* FindCorner(int32 GrabPointIndex, float Direction) const;
+
+	/** Compact id that replaces the actor reference in moves and replicated climbing state, 0 when the ledge can't be addressed over the network */
+	uint32 GetLedgeId() const { return LedgeId; }
+
+private:
+	friend class ULedgeRegistry;
+
+	TArray<FLedgeFace> Faces;
+	TArray<int32> PointFaces;
+
+	/** Assigned by the ledge registry on registration */
+	uint32 LedgeId = 0;
+
+	void BuildFaces();
 };
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "UObject/ObjectKey.h"
+#include "LedgeRegistry.generated.h"
+
+class ALedge;
+
+/**
+ * Keeps track of the ledges in a world and links the ends of their faces into corners.
+ * Ledges are partitioned by the level they belong to, so every streamed World Partition cell owns its own grids
+ * and the persistent level holds the always loaded ones. Face ends and ledge grab bounds are hashed into the partition's
+ * grids, linking and lookups only look at nearby cells of partitions whose bounds are in range.
+ * Cells streaming in have their grids built on a worker and merged on the next tick, a cell streaming out drops its partition in one go.
+ * Ledges are treated as static once registered, a ledge that moves has to register again.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API ULedgeRegistry : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Registers the ledge or refreshes it, then links its face ends and those of its neighbours */
+	void RegisterLedge(ALedge* Ledge);
+	void UnregisterLedge(ALedge* Ledge);
+
+	/** Includes ledges whose partition is still being built */
+	int32 GetNumLedges() const { return LedgeEntries.Num(); }
+
+	using FLedgeList = TArray<ALedge*, TInlineAllocator<16>>;
+
+	/** Ledges whose grab bounds overlap Box, each listed once */
+	void GatherLedges(const FBox& Box, FLedgeList& OutLedges) const;
+
+	/**
+	 * Registered ledge with the given network id, null for 0, a ledge that isn't loaded here, or an id shared by
+	 * several loaded ledges. Colliding ids stay unresolvable whatever order their ledges registered in.
+	 */
+	ALedge* ResolveLedge(uint32 LedgeId) const;
+
+	/**
+	 * Hash of the ledge's full path without the PIE prefix, so the level package tells apart ledges of level instances
+	 * and World Partition cells. The same on every machine that loaded the level.
+	 * 0 for ledges whose name isn't stable for networking, e.g. spawned at runtime.
+	 */
+	static uint32 MakeLedgeId(const ALedge* Ledge);
+
+	/** Logs ledge counts and memory of every loaded partition */
+	void ReportPartitions() const;
+
+	/** Maximum distance between two face ends that form a corner */
+	static constexpr float CornerLinkDistance = 80.f;
+	static constexpr float CellSize = 200.f;
+
+private:
+	struct FFaceEnd
+	{
+		TWeakObjectPtr<ALedge> Ledge;
+		int32 Face;
+		int32 End;
+		FVector Location;
+	};
+
+	/** What a ledge added to the grids, kept to remove it again without a full scan */
+	struct FRegisteredLedge
+	{
+		TArray<FFaceEnd> Ends;
+		FIntVector MinCell = FIntVector::ZeroValue;
+		FIntVector MaxCell = FIntVector(-1);
+		uint32 Serial = 0;
+	};
+
+	/** Everything the grids need from a ledge, copied on the game thread so partitions can be built anywhere */
+	struct FLedgeSnapshot
+	{
+		TWeakObjectPtr<ALedge> Ledge;
+		TArray<FFaceEnd> Ends;
+		FBox Bounds;
+		uint32 Serial = 0;
+	};
+
+	/** Grids of the ledges of one level */
+	struct FPartition
+	{
+		TMap<TWeakObjectPtr<ALedge>, FRegisteredLedge> Ledges;
+		TMap<FIntVector, TArray<FFaceEnd>> EndGrid;
+		TMap<FIntVector, TArray<TWeakObjectPtr<ALedge>, TInlineAllocator<4>>> LedgeGrid;
+		/** Covers every face end and grab bound ever added, culls the whole partition from lookups */
+		FBox Bounds = FBox(ForceInit);
+
+		/** Pure data, safe on any thread */
+		void Add(const FLedgeSnapshot& Snapshot);
+		void Append(FPartition&& Other);
+		void RemoveFromGrid(const TWeakObjectPtr<ALedge>& Ledge, const FRegisteredLedge& Entry);
+		SIZE_T GetAllocatedSize() const;
+	};
+
+	/** Partition a registered ledge lives in, the serial tells a refreshed ledge from its stale builds */
+	struct FLedgeEntry
+	{
+		TObjectKey<ULevel> Level;
+		uint32 Serial = 0;
+		uint32 LedgeId = 0;
+	};
+
+	struct FPartitionBuild
+	{
+		TObjectKey<ULevel> Level;
+		UE::Tasks::TTask<FPartition> Task;
+	};
+
+	TMap<TObjectKey<ULevel>, FPartition> Partitions;
+	TMap<TWeakObjectPtr<ALedge>, FLedgeEntry> LedgeEntries;
+	/** Every registered ledge per id, more than one means the id collided */
+	TMap<uint32, TArray<TWeakObjectPtr<ALedge>, TInlineAllocator<1>>> LedgesById;
+	/** Ledges of streamed levels waiting for the next tick to start their partition build */
+	TMap<TObjectKey<ULevel>, TArray<FLedgeSnapshot>> QueuedSnapshots;
+	TArray<FPartitionBuild> Builds;
+	uint32 NextSerial = 0;
+	FDelegateHandle LevelRemovedHandle;
+
+	void RemoveLedgeId(uint32 LedgeId, const TWeakObjectPtr<ALedge>& Ledge);
+	static FIntVector GetCell(const FVector& Location);
+	TArray<FFaceEnd> GetEnds(ALedge* Ledge) const;
+	bool ShouldBuildAsync(const ALedge* Ledge) const;
+	/** Drops ledges that were unregistered or refreshed since the snapshot, then links what is left */
+	void MergePartition(const TObjectKey<ULevel>& Level, FPartition&& Built);
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+	void GatherNearbyEnds(const FVector& Location, TArray<FFaceEnd>& OutEnds) const;
+	void LinkEnd(const FFaceEnd& End);
+	void RelinkNeighbours(const TArray<FFaceEnd>& Ends, const TSet<const ALedge*>& Except);
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Ledge.h"
+#include "SplineLedge.generated.h"
+
+class USplineComponent;
+
+/**
+ * Ledge whose top front edge is a spline. The edge is sampled into an arc-length table with a segment BVH on top,
+ * so hang location, shimmy extent and corners are analytic lookups instead of per-frame sweeps.
+ */
+UCLASS()
+class SHOOTERADVENTURE_API ASplineLedge : public ALedge
+{
+	GENERATED_BODY()
+
+public:
+	ASplineLedge();
+
+protected:
+	virtual void PostInitializeComponents() override;
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Climbing) USplineComponent* Edge;
+
+	/** The wall normal points to the right of the spline direction, otherwise to its left */
+	UPROPERTY(EditAnywhere, Category=Climbing) bool bWallFacesRight = true;
+	UPROPERTY(EditAnywhere, Category=Climbing, meta=(ClampMin=1)) float SampleSpacing = 10.f;
+
+	/** Turns sharper than this between two samples are corners, gentler curves are followed while shimmying */
+	UPROPERTY(EditAnywhere, Category=Climbing) float CornerAngle = 45.f;
+
+	UFUNCTION(BlueprintCallable, CallInEditor, Category=Climbing) void RebuildEdge();
+
+	/** Launch targets snap anywhere along the edge instead of to discrete points */
+	virtual bool GetClosestGrabPoint(FVector Origin, FLedgeGrabPoint& OutPoint) const override;
+	virtual FBox GetGrabBounds() const override;
+
+	float GetEdgeLength() const { return ArcLengths.Num() > 0 ? ArcLengths.Last() : 0.f; }
+	bool IsClosedLoop() const { return bClosedLoop; }
+
+	/** Wraps on closed loops, clamps otherwise */
+	float NormalizeDistance(float Distance) const;
+	bool IsDistanceOnEdge(float Distance) const;
+
+	/** Binary search in the arc-length table */
+	FLedgeGrabPoint GetEdgePointAtDistance(float Distance) const;
+	FVector GetEdgeTangentAtDistance(float Distance) const;
+
+	/** Closest point on the edge through the segment BVH */
+	bool FindClosestEdgePoint(const FVector& WorldLocation, FLedgeGrabPoint& OutPoint, float& OutDistance) const;
+
+	/**
+	 * First corner from Distance in Direction (+1 along the spline, -1 against it) within Range.
+	 * bInside is true when the edge turns towards the wall normal.
+	 */
+	bool FindCorner(float Distance, float Direction, float Range, float& OutCornerDistance, bool& bOutInside) const;
+
+private:
+	struct FEdgeNode
+	{
+		FBox3f Bounds;
+		/** Leaves store a segment range, inner nodes store their children */
+		int32 First;
+		int32 Second;
+		bool bLeaf;
+	};
+
+	static constexpr int32 SegmentsPerLeaf = 4;
+
+	/** Actor space samples, ArcLengths[i] is the distance along the edge of Samples[i] */
+	TArray<FVector3f> Samples;
+	TArray<FVector3f> SampleNormals;
+	TArray<float> ArcLengths;
+	TArray<FEdgeNode> Nodes;
+	TArray<float> CornerDistances;
+	TArray<bool> CornerInside;
+	bool bClosedLoop = false;
+
+	int32 BuildNode(int32 FirstSegment, int32 NumSegments);
+	int32 FindSegmentAtDistance(float Distance) const;
+	FLedgeGrabPoint MakeEdgePoint(int32 Segment, float Alpha) const;
+};
@@ -3,5 +3,7 @@
 #include "ShooterAdventure.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogAdventureMovement);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ShooterAdventure, "ShooterAdventure" );
  
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ShooterAdventureCharacter.h"
+#include "ShooterAdventure.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
@@ -10,12 +11,91 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "AdventureMovementComponent.h"
+#include "AdventureMovementTelemetry.h"
 #include "ClimbingComponent.h"
+#include "SplineLedge.h"
+#include "LedgeRegistry.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "EngineUtils.h"
+
+static FAutoConsoleCommandWithWorld CharacterSizeReportCommand(
+	TEXT("Adventure.Characters.ReportSizes"),
+	TEXT("Logs the object sizes of adventure characters and their movement components"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UE_LOG(LogAdventureMovement, Log, TEXT("sizeof: character %d, climbing component %d, movement component %d, climbing config %d, movement config %d"),
+			(int32)sizeof(AShooterAdventureCharacter), (int32)sizeof(UClimbingComponent), (int32)sizeof(UAdventureMovementComponent),
+			(int32)sizeof(UClimbingConfig), (int32)sizeof(UAdventureMovementConfig));
+
+		int32 NumCharacters = 0;
+		SIZE_T CharacterBytes = 0;
+		for(TActorIterator<AShooterAdventureCharacter> It(World); It; ++It)
+		{
+			NumCharacters++;
+			CharacterBytes += It->GetClass()->GetStructureSize();
+			It->ForEachComponent(false, [&CharacterBytes](const UActorComponent* Component)
+			{
+				CharacterBytes += Component->GetClass()->GetStructureSize();
+			});
+		}
+
+		UE_LOG(LogAdventureMovement, Log, TEXT("Characters: %d, %.1f KB of actor and component objects (%.0f bytes each)"),
+			NumCharacters, CharacterBytes / 1024.f, NumCharacters > 0 ? (float)CharacterBytes / NumCharacters : 0.f);
+	}));
 
 
+//////////////////////////////////////////////////////////////////////////
+// FClimbingReplicatedState
+
+bool FClimbingReplicatedState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	MotionWarpLocation.NetSerialize(Ar, Map, bOutSuccess);
+	MotionWarpRotation.SerializeCompressedShort(Ar);
+	Ar << HorizontalDirection;
+
+	// Climbing state fits in 3 bits, shimmy flag in 1
+	uint8 PackedState = (ClimbingState & 0x7) | (bCanShimmy ? 0x8 : 0);
+	Ar.SerializeBits(&PackedState, 4);
+	if(Ar.IsLoading())
+	{
+		ClimbingState = PackedState & 0x7;
+		bCanShimmy = (PackedState & 0x8) != 0;
+	}
+
+	// A 32 bit id instead of an object reference, so ledges never need a NetGUID
+	uint8 bHasLedge = LedgeId != 0;
+	Ar.SerializeBits(&bHasLedge, 1);
+	if(bHasLedge)
+	{
+		Ar << LedgeId;
+	}
+	else if(Ar.IsLoading())
+	{
+		LedgeId = 0;
+	}
+
+	return true;
+}
+
+bool FClimbingReplicatedState::IsNetEquivalent(const FClimbingReplicatedState& Other) const
+{
+	return ClimbingState == Other.ClimbingState
+		&& bCanShimmy == Other.bCanShimmy
+		&& LedgeId == Other.LedgeId
+		&& HorizontalDirection == Other.HorizontalDirection
+		&& MotionWarpLocation.Equals(Other.MotionWarpLocation, 0.05f)
+		&& FRotator::CompressAxisToShort(MotionWarpRotation.Pitch) == FRotator::CompressAxisToShort(Other.MotionWarpRotation.Pitch)
+		&& FRotator::CompressAxisToShort(MotionWarpRotation.Yaw) == FRotator::CompressAxisToShort(Other.MotionWarpRotation.Yaw)
+		&& FRotator::CompressAxisToShort(MotionWarpRotation.Roll) == FRotator::CompressAxisToShort(Other.MotionWarpRotation.Roll);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // AShooterAdventureCharacter
 
+FName AShooterAdventureCharacter::CameraBoomName(TEXT("CameraBoom"));
+FName AShooterAdventureCharacter::FollowCameraName(TEXT("FollowCamera"));
+
 AShooterAdventureCharacter::AShooterAdventureCharacter(const FObjectInitializer& ObjectInitializer)
 	:Super(ObjectInitializer.SetDefaultSubobjectClass<UAdventureMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
@@ -42,15 +122,29 @@ AShooterAdventureCharacter::AShooterAdventureCharacter(const FObjectInitializer&
 	GetCharacterMovement()->BrakingDecelerationWalking = 2000.f;
 
 	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 400.0f; // The camera follows at this distance behind the character	
-	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	// Optional so camera-less variants can skip the whole rig through the object initializer
+	CameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(CameraBoomName);
+	if(CameraBoom)
+	{
+		CameraBoom->SetupAttachment(RootComponent);
+		CameraBoom->TargetArmLength = 400.0f; // The camera follows at this distance behind the character	
+		CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	}
 
 	// Create a follow camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
-	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	FollowCamera = CreateOptionalDefaultSubobject<UCameraComponent>(FollowCameraName);
+	if(FollowCamera)
+	{
+		if(CameraBoom)
+		{
+			FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
+		}
+		else
+		{
+			FollowCamera->SetupAttachment(RootComponent);
+		}
+		FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	}
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
@@ -70,26 +164,63 @@ void AShooterAdventureCharacter::BeginPlay()
 			Subsystem->AddMappingContext(DefaultMappingContext, 0);
 		}
 	}
+
+	// Climbing decides shimmy and warp state before movement reads it, and the anim snapshot is published after both
+	AdventureMovementComponent->PrimaryComponentTick.AddPrerequisite(ClimbingComponent, ClimbingComponent->PrimaryComponentTick);
+	RefreshClimbingTick();
+}
+
+void AShooterAdventureCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	LevelAddedHandle.Reset();
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AShooterAdventureCharacter::Tick(float DeltaSeconds)
+void AShooterAdventureCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
 {
-	Super::Tick(DeltaSeconds);
-	ClimbingUpdate(DeltaSeconds);
-	FString Message = FString::Printf(TEXT("Velocity: %s"), *GetVelocity().ToString());
-	GEngine->AddOnScreenDebugMessage(10, 5, FColor::Yellow, Message);
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+
+	if(AdventureMovementComponent->MovementMode == MOVE_Walking)
+	{
+		ResetLedge();
+		AdventureMovementComponent->ClearClimbingTimer();
+		if(ClimbingState != CLIMB_NONE)
+		{
+			SetClimbingState(CLIMB_NONE);
+			return;
+		}
+	}
+
+	RefreshClimbingTick();
 }
 
-FCollisionQueryParams AShooterAdventureCharacter::GetIgnoreCharacterParam() const
+void AShooterAdventureCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
-	FCollisionQueryParams Params;
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	TArray<AActor*> CharacterChildren;
-	GetAllChildActors(CharacterChildren);
-	Params.AddIgnoredActor(this);
-	Params.AddIgnoredActors(CharacterChildren);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterAdventureCharacter, ReplicatedClimbingState, Params);
+}
 
-	return  Params;
+const FCollisionQueryParams& AShooterAdventureCharacter::GetIgnoreCharacterParam() const
+{
+	return ClimbingComponent->GetIgnoreOwnerParams();
+}
+
+void AShooterAdventureCharacter::NotifyJumpApex()
+{
+	Super::NotifyJumpApex();
+
+	if(ClimbingState == CLIMB_NONE)
+	{
+		// The ledge jumped from can be grabbed again once falling
+		ResetLedge();
+		RefreshClimbingTick();
+	}
 }
 
 void AShooterAdventureCharacter::ClimbingUpdate(float DeltaTime)
@@ -99,17 +230,32 @@ void AShooterAdventureCharacter::ClimbingUpdate(float DeltaTime)
 		return;
 	}
 
-	FString Message = FString::Printf(TEXT("Climbing State: %s"), *FString::FromInt(ClimbingState));
-	GEngine->AddOnScreenDebugMessage(1, 0, FColor::Blue, Message);
-
 	switch (ClimbingState)
 	{
 	case CLIMB_NONE:
 		if(AdventureMovementComponent->IsFalling() && AdventureMovementComponent->Velocity.Z <= 0)
 		{
+			// Far from climbable geometry the component only wakes up at IdleFallingTickInterval
+			const bool bNearLedge = ClimbingComponent->IsNearClimbableGeometry(AdventureMovementComponent->Velocity);
+			ClimbingComponent->SetComponentTickInterval(bNearLedge ? 0.f : ClimbingComponent->GetConfig().IdleFallingTickInterval);
+			if(!bNearLedge)
+			{
+				return;
+			}
+
+			if(ClimbingComponent->CanPrefetchLedges())
+			{
+				bool bReachedPrefetch;
+				if(ClimbingComponent->UpdateLedgePrefetch(AdventureMovementComponent->Velocity, AdventureMovementComponent->GetGravityZ(), CurrentLedge, bReachedPrefetch) && !bReachedPrefetch)
+				{
+					// Still falling towards the predicted ledge
+					break;
+				}
+			}
+
 			FHitResult FwdHit;
 			FHitResult TopHit;
-			if(ClimbingComponent->FoundLedge(FwdHit, TopHit))
+			if(ClimbingComponent->FoundFallingLedge(FwdHit, TopHit))
 			{
 				if(CurrentLedge == TopHit.GetActor())
 				{
@@ -119,6 +265,11 @@ void AShooterAdventureCharacter::ClimbingUpdate(float DeltaTime)
 				CurrentLedge = TopHit.GetActor();
 				FVector Location = ClimbingComponent->GetCharacterLocationOnLedge(FwdHit, TopHit);
 				FRotator Rotation = ClimbingComponent->GetCharacterRotationOnLedge(FwdHit);
+				if(const ASplineLedge* SplineLedge = Cast<ASplineLedge>(CurrentLedge))
+				{
+					// The proxy only found the ledge, the hang itself comes from the edge
+					ClimbingComponent->GetHangOnSplineLedge(SplineLedge, Location, Rotation, CurrentLedgeDistance);
+				}
 				StartClimb(Location, Rotation);
 			}
 		}
@@ -142,24 +293,90 @@ void AShooterAdventureCharacter::ClimbingUpdate(float DeltaTime)
 	default:
 		break;
 	}
-	
-	if(AdventureMovementComponent->MovementMode == MOVE_Walking)
+
+	PublishClimbingState();
+}
+
+void AShooterAdventureCharacter::SetClimbingState(EClimbingState NewState)
+{
+	if(FAdventureMovementTelemetry::IsEnabled() && NewState != ClimbingState)
 	{
-		ClimbingState = CLIMB_NONE;
+		FAdventureMovementTelemetry::RecordClimbingTransition(ClimbingState, NewState);
 	}
+
+	ClimbingState = NewState;
+	RefreshClimbingTick();
+	PublishClimbingState();
+}
+
+void AShooterAdventureCharacter::RefreshClimbingTick()
+{
+	if(ClimbingComponent == nullptr)
+	{
+		return;
+	}
+
+	// Launching, warping and leaving wait on the climbing timer or a montage notify, so they don't need a tick
+	bool bNeedsTick = false;
+	if(GetLocalRole() != ROLE_SimulatedProxy)
+	{
+		switch (ClimbingState)
+		{
+		case CLIMB_NONE:
+			// Ledges are only grabbed on the way down, rising jumps wake the component up again at the apex
+			bNeedsTick = AdventureMovementComponent->IsFalling() && AdventureMovementComponent->Velocity.Z <= 0;
+			bNotifyApex = AdventureMovementComponent->IsFalling() && !bNeedsTick;
+			break;
+		case CLIMB_INTERPOLATING:
+		case CLIMB_HANGING:
+			bNeedsTick = true;
+			ClimbingComponent->SetComponentTickInterval(0.f);
+			break;
+		default:
+			break;
+		}
+	}
+
+	ClimbingComponent->SetComponentTickEnabled(bNeedsTick);
+}
+
+void AShooterAdventureCharacter::PublishAnimSnapshot()
+{
+	// Anim workers only read the front buffer and finish before the next movement tick, so two buffers are enough
+	const int32 BackIndex = 1 - FrontAnimSnapshot.load(std::memory_order_relaxed);
+	FAdventureAnimSnapshot& Snapshot = AnimSnapshots[BackIndex];
+
+	Snapshot.Velocity = AdventureMovementComponent->Velocity;
+	Snapshot.Acceleration = AdventureMovementComponent->GetCurrentAcceleration();
+	Snapshot.GroundSpeed = Snapshot.Velocity.Size2D();
+	Snapshot.MovementMode = AdventureMovementComponent->MovementMode;
+	Snapshot.CustomMovementMode = static_cast<ECustomMovementMode>(AdventureMovementComponent->CustomMovementMode);
+	Snapshot.bIsFalling = AdventureMovementComponent->IsFalling();
+	Snapshot.bIsCrouching = AdventureMovementComponent->IsCrouching();
+	Snapshot.bIsAccelerating = !Snapshot.Acceleration.IsNearlyZero();
+
+	Snapshot.ClimbingState = ClimbingState;
+	Snapshot.bCanShimmy = bCanShimmy;
+	Snapshot.HorizontalDirection = HorizontalDirection;
+	Snapshot.MotionWarpLocation = MotionWarpLocation;
+	Snapshot.MotionWarpRotation = MotionWarpRotation;
+
+	FrontAnimSnapshot.store(BackIndex, std::memory_order_release);
 }
 
 void AShooterAdventureCharacter::ResetLedge()
 {
 	CurrentLedge = nullptr;
+	ClimbingComponent->ResetLedgePrefetch();
 }
 
 void AShooterAdventureCharacter::StartClimb(FVector InitialLocation, FRotator InitialRotation)
 {
+	AdventureMovementComponent->StopLaunch();
 	InterpolateToTarget(InitialLocation, InitialRotation);
 
 	AdventureMovementComponent->SetMovementMode(MOVE_Custom, CMOVE_Climbing);
-	StopAnimMontage(ClimbingComponent->DropClimbMontage);
+	StopAnimMontage(ClimbingComponent->GetConfig().DropClimbMontage);
 }
 
 void AShooterAdventureCharacter::InterpolateToTarget(FVector Location, FRotator Rotation)
@@ -167,7 +384,7 @@ void AShooterAdventureCharacter::InterpolateToTarget(FVector Location, FRotator
 	TargetInterpolateLocation = Location;
 	TargetInterpolateRotation = Rotation;
 
-	ClimbingState = CLIMB_INTERPOLATING;
+	SetClimbingState(CLIMB_INTERPOLATING);
 }
 
 void AShooterAdventureCharacter::DoClimbJump()
@@ -183,7 +400,14 @@ void AShooterAdventureCharacter::DoClimbJump()
 		const float InputHorDirection = FVector::DotProduct(Acceleration.GetSafeNormal2D(), GetActorRightVector());
 		if(FMath::Abs(InputHorDirection) > 0.15f)
 		{
-			JumpSide(InputHorDirection);
+			if(bUseScheduledClimbingQueries)
+			{
+				JumpSideAsync(InputHorDirection);
+			}
+			else
+			{
+				JumpSide(InputHorDirection);
+			}
 			return;
 		}
 	}
@@ -208,12 +432,18 @@ void AShooterAdventureCharacter::DropClimb()
 		return;
 	}
 
-	PlayAnimMontage(ClimbingComponent->DropClimbMontage);
-	ClimbingState = CLIMB_LEAVING;
+	PlayAnimMontage(ClimbingComponent->GetConfig().DropClimbMontage);
+	SetClimbingState(CLIMB_LEAVING);
 }
 
 void AShooterAdventureCharacter::UpdateClimbingMovement()
 {
+	if(const ASplineLedge* SplineLedge = Cast<ASplineLedge>(CurrentLedge))
+	{
+		UpdateSplineClimbingMovement(SplineLedge);
+		return;
+	}
+
 	FHitResult FwdHit, TopHit;
 	if(ClimbingComponent->FoundLedge(FwdHit, TopHit))
 	{
@@ -252,25 +482,55 @@ void AShooterAdventureCharacter::UpdateClimbingMovement()
 	}
 }
 
-void AShooterAdventureCharacter::StopShimmy()
+void AShooterAdventureCharacter::UpdateSplineClimbingMovement(const ASplineLedge* Ledge)
 {
-	HorizontalDirection = 0;
-	AdventureMovementComponent->Velocity = FVector::ZeroVector;
-}
+	FVector Location;
+	FRotator Rotation;
+	if(!ClimbingComponent->GetHangOnSplineLedge(Ledge, Location, Rotation, CurrentLedgeDistance))
+	{
+		return;
+	}
+
+	// Re-projecting onto the edge every update lets the hang follow curves without any sweep
+	FHitResult MoveHit;
+	AdventureMovementComponent->SafeMoveUpdatedComponent(Location - GetActorLocation(), Rotation.Quaternion(), false, MoveHit);
 
-void AShooterAdventureCharacter::LaunchToLedge()
-{
-	FVector LaunchVelocity;
 	const FVector Acceleration = AdventureMovementComponent->GetCurrentAcceleration();
-	if(ClimbingComponent->GetValidLaunchVelocity(ClimbingComponent->GetReachableGrabPoints(Acceleration.GetSafeNormal2D()), LaunchVelocity, AdventureMovementComponent->GetGravityZ()))
+	if(Acceleration.SizeSquared() <= 10.f)
 	{
-		LaunchCharacter(LaunchVelocity, true, true);
-		
-		FHitResult Hit;
-		const FQuat Rotation = FRotationMatrix::MakeFromXZ(LaunchVelocity.GetSafeNormal2D(), FVector::UpVector).ToQuat();
-		AdventureMovementComponent->SafeMoveUpdatedComponent(FVector::ZeroVector, Rotation, false, Hit);
-		SetClimbingTimer(0.5f, CLIMB_LAUNCHING);
+		HorizontalDirection = 0;
+		return;
+	}
+
+	const float ShimmyDirection = FVector::DotProduct(Acceleration.GetSafeNormal2D(), GetActorRightVector());
+	bCanShimmy = ClimbingComponent->CanMoveAlongSplineLedge(Ledge, CurrentLedgeDistance, ShimmyDirection);
+	if(bCanShimmy)
+	{
+		HorizontalDirection = ShimmyDirection;
+		return;
 	}
+
+	bool bInside;
+	if(ClimbingComponent->FindSplineLedgeCorner(Ledge, CurrentLedgeDistance, ShimmyDirection, MotionWarpLocation, MotionWarpRotation, bInside))
+	{
+		OnCornerStart.Broadcast();
+
+		const UClimbingConfig& Config = ClimbingComponent->GetConfig();
+		UAnimMontage* MontageToPlay = bInside
+			? (ShimmyDirection > 0 ? Config.RightCornerInMontage : Config.LeftCornerInMontage)
+			: (ShimmyDirection > 0 ? Config.RightCornerOutMontage : Config.LeftCornerOutMontage);
+		const float Duration = PlayAnimMontage(MontageToPlay);
+		SetClimbingTimer(Duration, CLIMB_WARPING);
+		return;
+	}
+
+	StopShimmy();
+}
+
+void AShooterAdventureCharacter::StopShimmy()
+{
+	HorizontalDirection = 0;
+	AdventureMovementComponent->Velocity = FVector::ZeroVector;
 }
 
 void AShooterAdventureCharacter::FinishClimbingTimer()
@@ -281,7 +541,7 @@ void AShooterAdventureCharacter::FinishClimbingTimer()
 	}
 	else if(ClimbingState == CLIMB_WARPING)
 	{
-		ClimbingState = CLIMB_HANGING;
+		SetClimbingState(CLIMB_HANGING);
 	}
 }
 
@@ -292,7 +552,7 @@ void AShooterAdventureCharacter::ProccessInterpolation(float DeltaTime)
 	if(ActorLocation.Equals(TargetInterpolateLocation, 0.001f))
 	{			
 		AdventureMovementComponent->SafeMoveUpdatedComponent(TargetInterpolateLocation - ActorLocation, TargetInterpolateRotation.Quaternion(), false, Hit);
-		ClimbingState = CLIMB_HANGING;
+		SetClimbingState(CLIMB_HANGING);
 		return;
 	}
 
@@ -305,11 +565,15 @@ void AShooterAdventureCharacter::ProccessInterpolation(float DeltaTime)
 
 bool AShooterAdventureCharacter::TryCornerOut(float Direction)
 {
-	if(ClimbingComponent->CanCornerOut(Direction, MotionWarpLocation, MotionWarpRotation))
+	bool bInside;
+	if(ClimbingComponent->FindLedgeCorner(Cast<ALedge>(CurrentLedge), Direction, MotionWarpLocation, MotionWarpRotation, bInside))
 	{
 		OnCornerStart.Broadcast();					
 					
-		UAnimMontage* MontageToPlay = Direction > 0 ? ClimbingComponent->RightCornerOutMontage : ClimbingComponent->LeftCornerOutMontage;
+		const UClimbingConfig& Config = ClimbingComponent->GetConfig();
+		UAnimMontage* MontageToPlay = bInside
+			? (Direction > 0 ? Config.RightCornerInMontage : Config.LeftCornerInMontage)
+			: (Direction > 0 ? Config.RightCornerOutMontage : Config.LeftCornerOutMontage);
 		const float Duration = PlayAnimMontage(MontageToPlay);
 		SetClimbingTimer(Duration, CLIMB_WARPING);
 		return true;
@@ -322,7 +586,7 @@ void AShooterAdventureCharacter::ClimbUp()
 {	
 	OnClimbUp.Broadcast();
 
-	const float Duration = PlayAnimMontage(ClimbingComponent->ClimbUpMontage);
+	const float Duration = PlayAnimMontage(ClimbingComponent->GetConfig().ClimbUpMontage);
 	SetClimbingTimer(Duration - 0.1f, CLIMB_LEAVING);
 }
 
@@ -331,18 +595,21 @@ void AShooterAdventureCharacter::JumpUp()
 	if(ClimbingComponent->CanHopUp(MotionWarpLocation))
 	{
 		OnClimbJumpStart.Broadcast();
-		const float MontageDuration = PlayAnimMontage(ClimbingComponent->HopUpMontage);
+		const float MontageDuration = PlayAnimMontage(ClimbingComponent->GetConfig().HopUpMontage);
 		SetClimbingTimer(MontageDuration, CLIMB_WARPING);		
 	}
 	else
 	{
+		if(FAdventureMovementTelemetry::IsEnabled())
+		{
+			FAdventureMovementTelemetry::RecordFailedHopUp();
+		}
+
 		const FVector LaunchVelocity = ClimbingComponent->GetJumpUpVelocity(AdventureMovementComponent->GetGravityZ());
-		LaunchCharacter(LaunchVelocity, true, true);
 		const float Duration = -LaunchVelocity.Z / AdventureMovementComponent->GetGravityZ();
+		AdventureMovementComponent->LaunchAlongArc(LaunchVelocity, Duration);
 		SetClimbingTimer(Duration, CLIMB_LAUNCHING);
 	}
-	
-	GEngine->AddOnScreenDebugMessage(3, 2, FColor::Blue, TEXT("Start Jump UP"));
 }
 
 void AShooterAdventureCharacter::JumpSide(float HorDirection)
@@ -352,36 +619,254 @@ void AShooterAdventureCharacter::JumpSide(float HorDirection)
 
 	FVector LaunchVelocity;
 	float Duration = -1.f;
-	if(!ClimbingComponent->FoundSideLedge(CurrentLedge, Direction, LaunchVelocity, AdventureMovementComponent->GetGravityZ(), Duration))
+	const bool bFoundLedge = ClimbingComponent->FoundSideLedge(CurrentLedge, Direction, LaunchVelocity, AdventureMovementComponent->GetGravityZ(), Duration);
+	ApplyJumpSide(Direction, bFoundLedge, LaunchVelocity, Duration);
+}
+
+void AShooterAdventureCharacter::JumpSideAsync(float HorDirection)
+{
+	if(bClimbingQueryPending)
+	{
+		return;
+	}
+
+	bClimbingQueryPending = true;
+	const FVector Direction = GetCapsuleComponent()->GetRightVector() * (HorDirection > 0 ? 1 : -1);
+	ClimbingComponent->RequestSideLedge(CurrentLedge, Direction, AdventureMovementComponent->GetGravityZ(), [this, Direction](bool bFound, const FVector& LaunchVelocity, float Duration)
 	{
-		LaunchVelocity = Direction * 500.f + FVector::UpVector * 600.0f;
+		bClimbingQueryPending = false;
+		if(AdventureMovementComponent->IsCustomMovementMode(CMOVE_Climbing) && ClimbingState == CLIMB_HANGING)
+		{
+			ApplyJumpSide(Direction, bFound, LaunchVelocity, Duration);
+		}
+		else if(FAdventureMovementTelemetry::IsEnabled())
+		{
+			// The character left the hang while the query was in flight
+			FAdventureMovementTelemetry::RecordFailedLaunch();
+		}
+	});
+}
+
+void AShooterAdventureCharacter::ApplyJumpSide(const FVector& Direction, bool bFoundLedge, FVector LaunchVelocity, float Duration)
+{
+	if(!bFoundLedge)
+	{
+		if(FAdventureMovementTelemetry::IsEnabled())
+		{
+			FAdventureMovementTelemetry::RecordFailedLaunch();
+		}
+
+		LaunchVelocity = ClimbingComponent->GetSideJumpFallbackVelocity(Direction);
 		Duration = -LaunchVelocity.Z / AdventureMovementComponent->GetGravityZ();
 	}
+
+	AdventureMovementComponent->LaunchAlongArc(LaunchVelocity, Duration);
 	
-	FString Message = FString::Printf(TEXT("Launch Velocity: %s"), *LaunchVelocity.ToString());
-	GEngine->AddOnScreenDebugMessage(3, 5, FColor::Green, Message);
-	LaunchCharacter(LaunchVelocity, true, true);
-	
-	/*UAnimMontage* Montage = bIsRight ? ClimbingComponent->ClimbJumpRightMontage : ClimbingComponent->ClimbJumpLeftMontage;	
+	/*UAnimMontage* Montage = bIsRight ? ClimbingComponent->GetConfig().ClimbJumpRightMontage : ClimbingComponent->GetConfig().ClimbJumpLeftMontage;	
 	PlayAnimMontage(Montage);*/
 	SetClimbingTimer(Duration, CLIMB_LAUNCHING);
-	GEngine->AddOnScreenDebugMessage(2, 2, FColor::Blue, TEXT("Start Jump Side"));
+}
+
+void AShooterAdventureCharacter::CancelClimbingQueries()
+{
+	ClimbingComponent->CancelRequests();
+	bClimbingQueryPending = false;
 }
 
 void AShooterAdventureCharacter::SetClimbingTimer(float Duration, EClimbingState TimerState)
 {
-	ClimbingState = TimerState;
-	GetWorld()->GetTimerManager().SetTimer(WarpTimerHandle, this, &AShooterAdventureCharacter::FinishClimbingTimer, Duration);
+	SetClimbingState(TimerState);
+	AdventureMovementComponent->SetClimbingTimer(Duration);
 }
 
 void AShooterAdventureCharacter::ExitClimbing()
 {	
+	CancelClimbingQueries();
 	AdventureMovementComponent->FindFloor(GetActorLocation(), AdventureMovementComponent->CurrentFloor, true, nullptr);		
 	AdventureMovementComponent->SetMovementMode(AdventureMovementComponent->CurrentFloor.IsWalkableFloor() ?  MOVE_Walking : MOVE_Falling);
 	HorizontalDirection = 0;
-	ClimbingState = CLIMB_NONE;
+	SetClimbingState(CLIMB_NONE);
+
+	AdventureMovementComponent->ClearClimbingTimer();
+}
 
-	GetWorld()->GetTimerManager().ClearTimer(WarpTimerHandle);
+void AShooterAdventureCharacter::PublishClimbingState()
+{
+	if(!IsLocallyControlled())
+	{
+		return;
+	}
+
+	FClimbingReplicatedState NewState;
+	NewState.MotionWarpLocation = MotionWarpLocation;
+	NewState.MotionWarpRotation = MotionWarpRotation;
+	NewState.HorizontalDirection = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(HorizontalDirection, -1.f, 1.f) * 127.f));
+	NewState.ClimbingState = ClimbingState;
+	NewState.bCanShimmy = bCanShimmy;
+	// Remote clients claim their ledge through their moves, where the server validates it
+	NewState.LedgeId = HasAuthority() ? GetCurrentLedgeId() : ReplicatedClimbingState.LedgeId;
+
+	if(NewState.IsNetEquivalent(ReplicatedClimbingState))
+	{
+		return;
+	}
+
+	if(HasAuthority())
+	{
+		SetReplicatedClimbingState(NewState);
+		return;
+	}
+
+	// The RPC is unreliable, so repeat the latest state a few times after each change
+	ReplicatedClimbingState = NewState;
+	ClimbingStateResendsLeft = 2;
+	Server_SetClimbingState(NewState);
+	GetWorldTimerManager().SetTimer(ClimbingStateResendTimerHandle, this, &AShooterAdventureCharacter::ResendClimbingState, 0.1f, true);
+}
+
+void AShooterAdventureCharacter::ResendClimbingState()
+{
+	Server_SetClimbingState(ReplicatedClimbingState);
+	if(--ClimbingStateResendsLeft <= 0)
+	{
+		GetWorldTimerManager().ClearTimer(ClimbingStateResendTimerHandle);
+	}
+}
+
+void AShooterAdventureCharacter::Server_SetClimbingState_Implementation(const FClimbingReplicatedState& NewState)
+{
+	if(!IsClimbingStateValid(NewState))
+	{
+		UE_LOG(LogAdventureMovement, Verbose, TEXT("%s: rejected climbing state %d"), *GetName(), NewState.ClimbingState);
+		return;
+	}
+
+	FClimbingReplicatedState ValidatedState = NewState;
+	ValidatedState.HorizontalDirection = FMath::Max<int8>(NewState.HorizontalDirection, -127);
+	ValidatedState.MotionWarpRotation = NewState.MotionWarpRotation.GetNormalized();
+	ValidatedState.LedgeId = ReplicatedClimbingState.LedgeId;
+	SetReplicatedClimbingState(ValidatedState);
+}
+
+bool AShooterAdventureCharacter::IsClimbingStateValid(const FClimbingReplicatedState& NewState) const
+{
+	// Dropping back to no climb or leaving only shrinks what proxies see, everything else has to match the server simulation
+	switch (NewState.ClimbingState)
+	{
+	case CLIMB_NONE:
+	case CLIMB_LEAVING:
+		return true;
+	case CLIMB_INTERPOLATING:
+	case CLIMB_HANGING:
+	case CLIMB_WARPING:
+		if(!AdventureMovementComponent->IsCustomMovementMode(CMOVE_Climbing) || CurrentLedge == nullptr)
+		{
+			return false;
+		}
+		break;
+	case CLIMB_LAUNCHING:
+		if(!AdventureMovementComponent->IsCustomMovementMode(CMOVE_Climbing) && !AdventureMovementComponent->IsFalling())
+		{
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+
+	if(NewState.MotionWarpLocation.ContainsNaN() || NewState.MotionWarpRotation.ContainsNaN())
+	{
+		return false;
+	}
+
+	// Warp targets sit on the ledge edge or on top of it, within a capsule height of a reachable grab point
+	const float MaxWarpDistance = AdventureMovementComponent->GetMaxLedgeGrabReach() + GetCapsuleComponent()->GetScaledCapsuleHalfHeight() * 2.f;
+	if(FVector::DistSquared(NewState.MotionWarpLocation, GetActorLocation()) > FMath::Square(MaxWarpDistance))
+	{
+		return false;
+	}
+
+	if(const ALedge* Ledge = Cast<ALedge>(CurrentLedge))
+	{
+		const FVector ClosestGrab = Ledge->GetGrabBounds().GetClosestPointTo(NewState.MotionWarpLocation);
+		if(FVector::DistSquared(ClosestGrab, NewState.MotionWarpLocation) > FMath::Square(MaxWarpDistance))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32 AShooterAdventureCharacter::GetCurrentLedgeId() const
+{
+	const ALedge* Ledge = ClimbingState != CLIMB_NONE ? Cast<ALedge>(CurrentLedge) : nullptr;
+	if(Ledge == nullptr)
+	{
+		return 0;
+	}
+
+	// A colliding id would resolve to another ledge, or to nothing, on the other end
+	const ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+	return Registry && Registry->ResolveLedge(Ledge->GetLedgeId()) == Ledge ? Ledge->GetLedgeId() : 0;
+}
+
+void AShooterAdventureCharacter::SetReplicatedLedgeId(uint32 LedgeId)
+{
+	if(ReplicatedClimbingState.LedgeId != LedgeId)
+	{
+		ReplicatedClimbingState.LedgeId = LedgeId;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterAdventureCharacter, ReplicatedClimbingState, this);
+	}
+}
+
+void AShooterAdventureCharacter::SetReplicatedClimbingState(const FClimbingReplicatedState& NewState)
+{
+	if(NewState.IsNetEquivalent(ReplicatedClimbingState))
+	{
+		return;
+	}
+
+	ReplicatedClimbingState = NewState;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterAdventureCharacter, ReplicatedClimbingState, this);
+}
+
+void AShooterAdventureCharacter::OnRep_ClimbingState()
+{
+	MotionWarpLocation = ReplicatedClimbingState.MotionWarpLocation;
+	MotionWarpRotation = ReplicatedClimbingState.MotionWarpRotation;
+	HorizontalDirection = ReplicatedClimbingState.HorizontalDirection / 127.f;
+	ClimbingState = static_cast<EClimbingState>(ReplicatedClimbingState.ClimbingState);
+	bCanShimmy = ReplicatedClimbingState.bCanShimmy;
+
+	ResolveReplicatedLedge();
+}
+
+void AShooterAdventureCharacter::ResolveReplicatedLedge()
+{
+	const ULedgeRegistry* Registry = GetWorld()->GetSubsystem<ULedgeRegistry>();
+	CurrentLedge = Registry ? Registry->ResolveLedge(ReplicatedClimbingState.LedgeId) : nullptr;
+
+	// The ledge's level may not have streamed in here yet
+	const bool bUnresolved = ReplicatedClimbingState.LedgeId != 0 && CurrentLedge == nullptr;
+	if(bUnresolved && !LevelAddedHandle.IsValid())
+	{
+		LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &AShooterAdventureCharacter::OnLevelAddedToWorld);
+	}
+	else if(!bUnresolved && LevelAddedHandle.IsValid())
+	{
+		FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+		LevelAddedHandle.Reset();
+	}
+}
+
+void AShooterAdventureCharacter::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	// Ledges register on BeginPlay, which the level's actors got before it was announced
+	if(World == GetWorld())
+	{
+		ResolveReplicatedLedge();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "InputActionValue.h"
+#include "AdventureMovementComponent.h"
+#include <atomic>
 #include "ShooterAdventureCharacter.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FClimbingDelegate);
@@ -20,6 +22,57 @@ enum EClimbingState
 	CLIMB_LEAVING
 };
 
+/** Packed climbing animation state replicated to simulated proxies */
+USTRUCT()
+struct FClimbingReplicatedState
+{
+	GENERATED_BODY()
+
+	UPROPERTY() FVector_NetQuantize10 MotionWarpLocation = FVector::ZeroVector;
+	UPROPERTY() FRotator MotionWarpRotation = FRotator::ZeroRotator;
+	UPROPERTY() int8 HorizontalDirection = 0;
+	UPROPERTY() uint8 ClimbingState = CLIMB_NONE;
+	UPROPERTY() bool bCanShimmy = true;
+	/** Ledge registry id, filled in by the server only */
+	UPROPERTY() uint32 LedgeId = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/** Compares at network precision so sub-quantization changes don't dirty the property */
+	bool IsNetEquivalent(const FClimbingReplicatedState& Other) const;
+};
+
+/** Animation inputs captured once per frame after movement, safe to read from worker threads */
+USTRUCT(BlueprintType)
+struct FAdventureAnimSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category=Movement) FVector Velocity = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) FVector Acceleration = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) float GroundSpeed = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) TEnumAsByte<ECustomMovementMode> CustomMovementMode = CMOVE_None;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) bool bIsFalling = false;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) bool bIsCrouching = false;
+	UPROPERTY(BlueprintReadOnly, Category=Movement) bool bIsAccelerating = false;
+
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) TEnumAsByte<EClimbingState> ClimbingState = CLIMB_NONE;
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) bool bCanShimmy = true;
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) float HorizontalDirection = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) FVector MotionWarpLocation = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category=Climbing) FRotator MotionWarpRotation = FRotator::ZeroRotator;
+};
+
+template<>
+struct TStructOpsTypeTraits<FClimbingReplicatedState> : public TStructOpsTypeTraitsBase2<FClimbingReplicatedState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 class UClimbingComponent;
 UCLASS(config=Game)
 class AShooterAdventureCharacter : public ACharacter
@@ -81,6 +134,12 @@ protected:
 	
 public:
 	AShooterAdventureCharacter(const FObjectInitializer& ObjectInitializer);
+
+	/** Name of the camera boom, use with ObjectInitializer.DoNotCreateDefaultSubobject to leave the camera rig out */
+	static FName CameraBoomName;
+
+	/** Name of the follow camera, use with ObjectInitializer.DoNotCreateDefaultSubobject to leave the camera rig out */
+	static FName FollowCameraName;
 		
 protected:
 
@@ -95,9 +154,12 @@ protected:
 	
 	// To add mapping context
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	virtual void Tick(float DeltaSeconds) override;
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+	virtual void NotifyJumpApex() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
@@ -106,33 +168,69 @@ public:
 	/** Return Adventure movement component **/
 	FORCEINLINE class UAdventureMovementComponent* GetAdventureMovementComponent() const { return AdventureMovementComponent; }
 	
-	FCollisionQueryParams GetIgnoreCharacterParam() const;
+	/** Ignores the character and its child actors, shared with the climbing component's queries */
+	const FCollisionQueryParams& GetIgnoreCharacterParam() const;
 	
-private:
+	/** Climbing state machine, ticked by the climbing component only while falling or hanging */
 	void ClimbingUpdate(float DeltaTime);
+
+	/** Registry id of the ledge the character climbs on, 0 while not climbing */
+	uint32 GetCurrentLedgeId() const;
+
+	/** Server only, the ledge simulated proxies resolve from the replicated climbing state */
+	void SetReplicatedLedgeId(uint32 LedgeId);
+
+private:
 	UFUNCTION() void ResetLedge();
 	AActor* CurrentLedge;
 
+	/** Distance along the edge while hanging from a spline ledge */
+	float CurrentLedgeDistance = 0.f;
+
 	UPROPERTY(EditDefaultsOnly, Category=Climbing) float InterpSpeed = 15.f;	
 	FVector TargetInterpolateLocation;
 	FRotator TargetInterpolateRotation;
-	FTimerHandle WarpTimerHandle;
 	EClimbingState ClimbingState;
 	
-	void LaunchToLedge();
 	void StartClimb(FVector InitialLocation, FRotator InitialRotation);
 	void InterpolateToTarget(FVector Location, FRotator Rotation);
 	void DoClimbJump();
-	void DropClimb();
 	void StopShimmy();
 	bool TryCornerOut(float Direction);
+	void UpdateSplineClimbingMovement(const class ASplineLedge* Ledge);
 	void ClimbUp();
 	void JumpUp();
 	void JumpSide(float HorDirection);
+	void JumpSideAsync(float HorDirection);
+	void ApplyJumpSide(const FVector& Direction, bool bFoundLedge, FVector LaunchVelocity, float Duration);
+
+	/** Probes triggered by input go through the climbing query scheduler and land one frame later */
+	UPROPERTY(EditDefaultsOnly, Category=Climbing) bool bUseScheduledClimbingQueries = true;
+	bool bClimbingQueryPending = false;
+	/** Drops scheduled probes whose result no longer applies, their callbacks never run */
+	void CancelClimbingQueries();
 
 	void SetClimbingTimer(float Duration, EClimbingState TimerState);
-	void FinishClimbingTimer();
+	void SetClimbingState(EClimbingState NewState);
+	void RefreshClimbingTick();
 	void ProccessInterpolation(float DeltaTime);
+
+	// Replication
+	UPROPERTY(ReplicatedUsing=OnRep_ClimbingState) FClimbingReplicatedState ReplicatedClimbingState;
+
+	UFUNCTION() void OnRep_ClimbingState();
+	/** Bound while the replicated ledge isn't loaded here, the lookup is retried as levels stream in */
+	FDelegateHandle LevelAddedHandle;
+	void ResolveReplicatedLedge();
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	UFUNCTION(Server, Unreliable) void Server_SetClimbingState(const FClimbingReplicatedState& NewState);
+	int32 ClimbingStateResendsLeft = 0;
+	FTimerHandle ClimbingStateResendTimerHandle;
+	void PublishClimbingState();
+	void ResendClimbingState();
+	void SetReplicatedClimbingState(const FClimbingReplicatedState& NewState);
+	/** Server check of a client published state against the server's own movement and ledge */
+	bool IsClimbingStateValid(const FClimbingReplicatedState& NewState) const;
 	
 public:			
 	UPROPERTY(BlueprintReadOnly, Category=Climbing)
@@ -159,7 +257,26 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void ExitClimbing();
 
+	/** Called by the movement component when the climbing timer runs out of simulation ticks */
+	void FinishClimbingTimer();
+
+	/** Captures this frame's animation inputs into the back buffer and flips it to the front */
+	void PublishAnimSnapshot();
+
+	/** Latest published snapshot, safe to call from the anim instance proxy on worker threads */
+	UFUNCTION(BlueprintPure, Category=Animation, meta=(BlueprintThreadSafe))
+	FAdventureAnimSnapshot GetAnimSnapshot() const { return AnimSnapshots[FrontAnimSnapshot.load(std::memory_order_acquire)]; }
+
+private:
+	FAdventureAnimSnapshot AnimSnapshots[2];
+	std::atomic<int32> FrontAnimSnapshot{0};
+
+public:
 	bool IsClimbingState(EClimbingState State) const {return  ClimbingState == State;}
+	EClimbingState GetClimbingState() const {return ClimbingState;}
+	UClimbingComponent* GetClimbingComponent() const {return ClimbingComponent;}
 	void UpdateClimbingMovement();
+	/** Lets go of the ledge while hanging, bound to the drop input and used by scripted movement */
+	void DropClimb();
 };
 
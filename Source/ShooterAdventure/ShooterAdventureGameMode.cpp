@@ -2,6 +2,9 @@
 
 #include "ShooterAdventureGameMode.h"
 #include "ShooterAdventureCharacter.h"
+#include "AdventureCharacterFactory.h"
+#include "AdventureBotCharacter.h"
+#include "ShooterAdventure.h"
 #include "UObject/ConstructorHelpers.h"
 
 AShooterAdventureGameMode::AShooterAdventureGameMode()
@@ -13,3 +16,30 @@ AShooterAdventureGameMode::AShooterAdventureGameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+UClass* AShooterAdventureGameMode::GetBotPawnClass() const
+{
+	if(BotPawnClass.IsNull())
+	{
+		return AAdventureBotCharacter::StaticClass();
+	}
+
+	UClass* Class = BotPawnClass.LoadSynchronous();
+	if(!ensureMsgf(Class != nullptr, TEXT("%s: BotPawnClass '%s' failed to load"), *GetName(), *BotPawnClass.ToString()))
+	{
+		UE_LOG(LogAdventureMovement, Error, TEXT("%s: BotPawnClass '%s' failed to load, bots won't spawn"), *GetName(), *BotPawnClass.ToString());
+		return nullptr;
+	}
+
+	return Class;
+}
+
+UClass* AShooterAdventureGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	if(UAdventureCharacterFactory::GetArchetypeFor(InController) == EAdventureCharacterArchetype::Bot)
+	{
+		return GetBotPawnClass();
+	}
+
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
@@ -6,13 +6,22 @@
 #include "GameFramework/GameModeBase.h"
 #include "ShooterAdventureGameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, config=Game)
 class AShooterAdventureGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AShooterAdventureGameMode();
+
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+
+	/** Loads BotPawnClass, falls back to AAdventureBotCharacter when it is unset and returns null when it fails to load */
+	UClass* GetBotPawnClass() const;
+
+	/** Pawn for controllers that aren't players, usually a Blueprint subclass of the camera-less AAdventureBotCharacter. Unset uses the native class */
+	UPROPERTY(config, EditAnywhere, NoClear, BlueprintReadOnly, Category=Classes)
+	TSoftClassPtr<APawn> BotPawnClass;
 };
 
 
@@ -10,6 +10,7 @@ public class ShooterAdventureEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("ShooterAdventure");
 	}
 }